@@ -0,0 +1,8 @@
+// std140 layout, mirrored by `CameraStd140` in src/camera.hpp, written once per frame for every program
+layout(std140, binding = 2) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+    // w is unused
+    vec4 view_position;
+} u_camera;
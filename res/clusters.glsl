@@ -0,0 +1,20 @@
+// std430 layouts, mirrored by `ClustersStd430` in src/light_clusters.hpp and filled every frame by `LightClusters`
+layout(std430, binding = 3) readonly buffer Clusters {
+    uvec4 u_cluster_dimensions;
+    // viewport width and height, depth slice scale and bias
+    vec4 u_cluster_scale;
+    // offset and count in `u_cluster_lights` of the lights of each cluster, x varying fastest, then y, then z
+    uvec2 u_cluster_ranges[];
+};
+
+layout(std430, binding = 4) readonly buffer ClusterLights {
+    uint u_cluster_lights[];
+};
+
+// lights reaching the fragment at window position `fragment` and view space distance `depth`
+uvec2 cluster_range(vec2 fragment, float depth) {
+    vec3 position = vec3(fragment / u_cluster_scale.xy * vec2(u_cluster_dimensions.xy),
+        max(log(depth) * u_cluster_scale.z - u_cluster_scale.w, 0.0));
+    uvec3 cluster = min(uvec3(position), u_cluster_dimensions.xyz - 1u);
+    return u_cluster_ranges[cluster.x + u_cluster_dimensions.x * (cluster.y + u_cluster_dimensions.y * cluster.z)];
+}
@@ -0,0 +1,60 @@
+#version 460 core
+
+// permutations: VOLUME adds the light of the volume to the texels it covers; otherwise the base pass writes every
+// texel once, the background color or, with FLASHLIGHT, the camera's spot light
+
+#include "camera.glsl"
+#include "lights.glsl"
+
+// written by res/gbuffer.frag, units mirrored by `gbuffer_unit` in src/gbuffer.hpp
+layout(binding = 2) uniform sampler2D u_gbuffer_position;
+layout(binding = 3) uniform sampler2D u_gbuffer_normal;
+layout(binding = 4) uniform sampler2D u_gbuffer_diffuse;
+layout(binding = 5) uniform sampler2D u_gbuffer_specular;
+
+#ifndef VOLUME
+uniform vec3 u_background;
+#endif
+
+flat in int v_light;
+
+out vec4 color;
+
+void main() {
+    ivec2 texel  = ivec2(gl_FragCoord.xy);
+    vec4 diffuse = texelFetch(u_gbuffer_diffuse, texel, 0);
+#ifdef VOLUME
+    if (diffuse.a == 0.0) {
+        discard;
+    }
+#else
+    if (diffuse.a == 0.0) {
+        color = vec4(u_background, 1.0);
+        return;
+    }
+#endif
+    vec3 position = texelFetch(u_gbuffer_position, texel, 0).xyz;
+    vec4 normal   = texelFetch(u_gbuffer_normal, texel, 0);
+    vec3 specular = texelFetch(u_gbuffer_specular, texel, 0).rgb;
+
+#ifdef VOLUME
+    Light light = u_lights[v_light];
+    if (distance(position, light.position.xyz) > light.radius) {
+        discard;
+    }
+    color = vec4(
+        phong(light, position, normal.xyz, diffuse.rgb, normal.w, specular, u_camera.view_position.xyz, false), 1.0);
+#elif defined(FLASHLIGHT)
+    color = vec4(phong(u_flashlight,
+                     position,
+                     normal.xyz,
+                     diffuse.rgb,
+                     normal.w,
+                     specular,
+                     u_camera.view_position.xyz,
+                     true),
+        1.0);
+#else
+    color = vec4(0.0, 0.0, 0.0, 1.0);
+#endif
+}
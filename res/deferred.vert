@@ -0,0 +1,23 @@
+#version 460 core
+
+// permutations: VOLUME draws the cube mesh once per light, scaled to its radius; otherwise a single triangle covers the
+// screen
+
+#include "camera.glsl"
+#include "lights.glsl"
+
+layout(location = 0) in vec3 a_position;
+
+flat out int v_light;
+
+void main() {
+#ifdef VOLUME
+    Light light = u_lights[gl_InstanceID];
+    v_light     = gl_InstanceID;
+    gl_Position = u_camera.view_projection * vec4(light.position.xyz + 2.0 * light.radius * a_position, 1.0);
+#else
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    v_light     = 0;
+    gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);
+#endif
+}
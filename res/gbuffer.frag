@@ -0,0 +1,25 @@
+#version 460 core
+
+// permutations: TEXTURED or SOLID material, the G-buffer pass of deferred shading; layout read back by res/deferred.frag
+
+#include "camera.glsl"
+#include "material.glsl"
+
+in vec3 v_position;
+in vec2 v_tex;
+in vec3 v_normal;
+
+// world position and view space depth
+layout(location = 0) out vec4 g_position;
+// world normal and shininess
+layout(location = 1) out vec4 g_normal;
+// alpha tells covered texels from the background, cleared to 0
+layout(location = 2) out vec4 g_diffuse;
+layout(location = 3) out vec4 g_specular;
+
+void main() {
+    g_position = vec4(v_position, -(u_camera.view * vec4(v_position, 1.0)).z);
+    g_normal   = vec4(normalize(v_normal), u_material.shininess);
+    g_diffuse  = vec4(material_diffuse(v_tex), 1.0);
+    g_specular = vec4(material_specular(v_tex), 1.0);
+}
@@ -0,0 +1,21 @@
+// irradiance of the static lights baked by `Lightmap` in src/lightmap.hpp, one tile per object; the layout is mirrored
+// by `LightmapLayout`
+struct LightmapLayout {
+    bool enabled;
+    // tiles per row, and their size in texels
+    int columns;
+    int tile_width;
+    int tile_height;
+};
+
+uniform LightmapLayout u_lightmap;
+
+// unit mirrored by `lightmap_unit` in src/lightmap.hpp
+layout(binding = 8) uniform sampler2D u_lightmap_texture;
+
+// `uv` are the lightmap coordinates of the vertices, within the tile of `object`
+vec3 lightmap(uint object, vec2 uv) {
+    vec2 tile  = vec2(u_lightmap.tile_width, u_lightmap.tile_height);
+    vec2 first = vec2(int(object) % u_lightmap.columns, int(object) / u_lightmap.columns) * tile;
+    return texture(u_lightmap_texture, (first + uv * tile) / vec2(textureSize(u_lightmap_texture, 0))).rgb;
+}
@@ -0,0 +1,76 @@
+// std430 layout, mirrored by `LightStd430` in src/light.hpp
+struct Light {
+    vec4 position;
+
+    vec3 direction;
+    bool is_directional;
+
+    vec3 ambient;
+    float cut_off;
+    vec3 diffuse;
+    float outer_cut_off;
+    vec3 specular;
+    float constant;
+
+    float linear;
+    float quadratic;
+    // distance at which the light has faded out, bounds its deferred shading volume
+    float radius;
+    // entry in `u_shadows`, -1 when the light casts no shadow
+    int shadow;
+};
+
+// kept by `LightRegistry` in src/light_registry.hpp, the head is mirrored by `LightsStd430` in src/light.hpp
+layout(std430, binding = 0) readonly buffer Lights {
+    int u_nlights;
+    // the camera's spot light, never culled
+    Light u_flashlight;
+    Light u_lights[];
+};
+
+#include "shadows.glsl"
+
+// windowed to reach 0 at the light's radius, mirrors `light_attenuation` in src/light.cpp
+float light_attenuation(Light light, float d) {
+    float ratio  = d / light.radius;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window / (light.constant + light.linear * d + light.quadratic * d * d);
+}
+
+// `cone` is a constant at every call site: the spot light attenuation is only compiled where it is needed. Lights
+// farther than their radius add nothing and return early, shadows only darken the diffuse and specular terms.
+vec3 phong(Light light, vec3 fragment_position, vec3 normal, vec3 object_color, float shininess, vec3 specular_color,
+    vec3 view_direction, const bool cone) {
+    float attenuation    = 1.0;
+    vec3 light_direction = vec3(0.0);
+    if (light.position.w == 0.0) {
+        light_direction = normalize(-light.position.xyz);
+    } else {
+        float d = length(light.position.xyz - fragment_position);
+        if (d > light.radius) {
+            return vec3(0.0);
+        }
+        light_direction = (light.position.xyz - fragment_position) / d;
+        attenuation     = light_attenuation(light, d);
+    }
+
+    vec3 ambient = light.ambient * object_color;
+
+    float intensity = 1.0;
+    if (cone) {
+        float theta = dot(light_direction, normalize(-light.direction));
+        intensity   = clamp((theta - light.outer_cut_off) / (light.cut_off - light.outer_cut_off), 0.0, 1.0);
+    }
+    if (light.shadow >= 0 && intensity > 0.0) {
+        intensity *= shadow(u_shadows[light.shadow], light.position.xyz, light.radius, fragment_position, normal);
+    }
+
+    vec3 diffuse = light.diffuse * (max(dot(normal, light_direction), 0.0) * object_color);
+    vec3 specular =
+        light.specular *
+        pow(max(dot(normalize(view_direction - fragment_position), reflect(-light_direction, normal)), 0.0),
+            shininess) *
+        specular_color;
+
+    return attenuation * (ambient + intensity * (diffuse + specular));
+}
@@ -0,0 +1,25 @@
+// permutations: TEXTURED or SOLID
+struct Material {
+    vec4 color;
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+uniform Material u_material;
+
+vec3 material_diffuse(vec2 tex) {
+#ifdef SOLID
+    return u_material.color.rgb;
+#else
+    return texture(u_material.diffuse, tex).rgb;
+#endif
+}
+
+vec3 material_specular(vec2 tex) {
+#ifdef SOLID
+    return u_material.color.rgb;
+#else
+    return texture(u_material.specular, tex).rgb;
+#endif
+}
@@ -0,0 +1,10 @@
+// std430 layouts filled every frame by `ObjectLights` in src/object_lights.hpp, objects indexed by their instance
+layout(std430, binding = 5) readonly buffer ObjectLightRanges {
+    // offset and count in `u_object_lights` of the lights reaching each object, a count of 0xffffffff for objects
+    // reached by too many lights to be listed
+    uvec2 u_object_light_ranges[];
+};
+
+layout(std430, binding = 6) readonly buffer ObjectLights {
+    uint u_object_lights[];
+};
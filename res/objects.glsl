@@ -0,0 +1,10 @@
+// std430 layout, mirrored by `ObjectStd430` in src/indirect_buffer.hpp
+struct Object {
+    mat4 model;
+    mat4 ti_model;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Objects {
+    Object u_objects[];
+};
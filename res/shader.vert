@@ -1,25 +1,31 @@
 #version 460 core
 
+#include "camera.glsl"
+
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec3 a_color;
 layout(location = 2) in vec2 a_tex;
 layout(location = 3) in vec3 a_normal;
+layout(location = 4) in vec2 a_lightmap;
 
 uniform mat4 u_model;
 uniform mat4 u_ti_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
 
 out vec3 v_color;
 out vec3 v_position;
 out vec2 v_tex;
 out vec3 v_normal;
+out vec2 v_lightmap;
+// index of the object in per object storage blocks
+flat out uint v_object;
 
 void main() {
     v_position = vec3(u_model * vec4(a_position, 1.0));
     v_color    = a_color;
     v_tex      = a_tex;
     v_normal   = mat3(u_ti_model) * a_normal;
+    v_lightmap = a_lightmap;
+    v_object   = uint(gl_BaseInstance + gl_InstanceID);
 
-    gl_Position = u_projection * u_view * vec4(v_position, 1.0);
+    gl_Position = u_camera.view_projection * vec4(v_position, 1.0);
 }
@@ -0,0 +1,19 @@
+#version 460 core
+
+// permutations: CUBE reads the positions of res/shadow.geom
+
+#ifdef CUBE
+in vec3 g_position;
+#define v_position g_position
+#else
+in vec3 v_position;
+#endif
+
+uniform vec3 u_light_position;
+// the light's radius, read back by res/shadows.glsl
+uniform float u_far;
+
+// the distance to the light rather than the projected depth, so that spot and cube maps compare the same way
+void main() {
+    gl_FragDepth = distance(v_position, u_light_position) / u_far;
+}
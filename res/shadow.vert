@@ -0,0 +1,21 @@
+#version 460 core
+
+// permutations: CUBE hands world positions over to res/shadow.geom, which projects them on the six faces of a cube
+// map; otherwise they are projected on a spot map
+
+#include "objects.glsl"
+
+layout(location = 0) in vec3 a_position;
+
+#ifndef CUBE
+uniform mat4 u_view_projection;
+#endif
+
+out vec3 v_position;
+
+void main() {
+    v_position = vec3(u_objects[gl_BaseInstance + gl_InstanceID].model * vec4(a_position, 1.0));
+#ifndef CUBE
+    gl_Position = u_view_projection * vec4(v_position, 1.0);
+#endif
+}
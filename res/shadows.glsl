@@ -0,0 +1,40 @@
+// std430 layout, mirrored by `ShadowStd430` in src/shadow_atlas.hpp
+struct Shadow {
+    // spot maps: world to light clip space, and the tile as offset and scale in atlas coordinates
+    mat4 view_projection;
+    vec4 tile;
+    // cube maps: the cube in the array, -1 for spot maps
+    int cube;
+};
+
+// written by `ShadowAtlas` whenever it renders a map
+layout(std430, binding = 7) readonly buffer Shadows {
+    Shadow u_shadows[];
+};
+
+// units mirrored by `shadow_cubes_unit` and `shadow_spots_unit` in src/shadow_atlas.hpp
+layout(binding = 6) uniform samplerCubeArrayShadow u_shadow_cubes;
+layout(binding = 7) uniform sampler2DShadow u_shadow_spots;
+
+// fraction of the light at `light_position` reaching `position`. Maps hold the distance to the light over `far`; the
+// point is moved off its surface by about a texel of the map along the normal, and compared a texel closer to the
+// light, against self shadowing.
+float shadow(Shadow map, vec3 light_position, float far, vec3 position, vec3 normal) {
+    float d = distance(light_position, position);
+    if (map.cube >= 0) {
+        float texel = 2.0 * d / float(textureSize(u_shadow_cubes, 0).x);
+        vec3 offset = position + texel * normal - light_position;
+        return texture(u_shadow_cubes, vec4(offset, float(map.cube)), (length(offset) - texel) / far);
+    }
+
+    float texel = 2.0 * d / (map.tile.z * float(textureSize(u_shadow_spots, 0).x));
+    vec3 offset = position + texel * normal;
+    vec4 clip   = map.view_projection * vec4(offset, 1.0);
+    vec2 uv     = 0.5 * clip.xy / clip.w + 0.5;
+    // outside of the cone the map does not cover, and the light does not reach either
+    if (clip.w <= 0.0 || any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) {
+        return 1.0;
+    }
+    return texture(u_shadow_spots,
+        vec3(map.tile.xy + uv * map.tile.zw, (distance(light_position, offset) - texel) / far));
+}
@@ -0,0 +1,9 @@
+#include "benchmark.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+void report(const std::string &name, double ns, const std::string &unit) {
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns << " ns/" << unit << "\n";
+}
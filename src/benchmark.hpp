@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// average wall clock time of one call to `f`, in nanoseconds, measured after `iterations / 10` warm up calls
+template <typename F> double measure(size_t iterations, F &&f) {
+    for (size_t i = 0; i < iterations / 10; ++i) {
+        f();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        f();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / iterations;
+}
+
+void report(const std::string &name, double ns, const std::string &unit = "call");
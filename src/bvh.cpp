@@ -0,0 +1,244 @@
+#include "bvh.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+// hits closer than this to the origin of a ray are taken for the surface it leaves
+constexpr static float t_min = 1e-4f;
+
+#if defined(__SSE2__)
+static inline __m128 dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+#endif
+
+void RayPacket::set(size_t lane, glm::vec3 origin, glm::vec3 direction, float far) {
+    ox[lane]       = origin.x;
+    oy[lane]       = origin.y;
+    oz[lane]       = origin.z;
+    dx[lane]       = direction.x;
+    dy[lane]       = direction.y;
+    dz[lane]       = direction.z;
+    t[lane]        = far;
+    triangle[lane] = -1;
+}
+
+void RayPacket::deactivate(size_t lane) {
+    set(lane, {}, {0.0f, 0.0f, 1.0f}, -1.0f);
+}
+
+Bvh::Bvh(const std::vector<glm::vec3> &corners) {
+    size_t triangles = corners.size() / 3;
+    std::vector<uint32_t> order(triangles);
+    std::vector<glm::vec3> centroids(triangles);
+    for (size_t i = 0; i < triangles; ++i) {
+        order[i]     = i;
+        centroids[i] = (corners[3 * i] + corners[3 * i + 1] + corners[3 * i + 2]) / 3.0f;
+    }
+    m_v0.reserve(triangles);
+    m_e1.reserve(triangles);
+    m_e2.reserve(triangles);
+    m_ids.reserve(triangles);
+    if (triangles > 0) {
+        build(order, centroids, corners, 0, triangles);
+    }
+}
+
+void Bvh::intersect(RayPacket &packet) const { traverse<false>(packet); }
+
+void Bvh::occluded(RayPacket &packet) const { traverse<true>(packet); }
+
+uint32_t Bvh::build(std::vector<uint32_t> &order, const std::vector<glm::vec3> &centroids,
+    const std::vector<glm::vec3> &corners, size_t begin, size_t end) {
+    uint32_t index = m_nodes.size();
+    m_nodes.push_back({});
+
+    glm::vec3 min = glm::vec3(INFINITY), max = glm::vec3(-INFINITY);
+    glm::vec3 centroid_min = min, centroid_max = max;
+    for (size_t i = begin; i < end; ++i) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            min = glm::min(min, corners[3 * order[i] + corner]);
+            max = glm::max(max, corners[3 * order[i] + corner]);
+        }
+        centroid_min = glm::min(centroid_min, centroids[order[i]]);
+        centroid_max = glm::max(centroid_max, centroids[order[i]]);
+    }
+
+    if (end - begin <= leaf_size) {
+        m_nodes[index] = {min, max, (uint32_t) m_v0.size(), (uint32_t) (end - begin), 0};
+        for (size_t i = begin; i < end; ++i) {
+            const glm::vec3 *triangle = &corners[3 * order[i]];
+            m_v0.push_back(triangle[0]);
+            m_e1.push_back(triangle[1] - triangle[0]);
+            m_e2.push_back(triangle[2] - triangle[0]);
+            m_ids.push_back(order[i]);
+        }
+        return index;
+    }
+
+    glm::vec3 extent = centroid_max - centroid_min;
+    uint32_t axis    = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+    size_t middle    = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b) {
+        return centroids[a][axis] < centroids[b][axis];
+    });
+
+    build(order, centroids, corners, begin, middle);
+    uint32_t second = build(order, centroids, corners, middle, end);
+    m_nodes[index]  = {min, max, second, 0, axis};
+    return index;
+}
+
+template <bool any> void Bvh::traverse(RayPacket &packet) const {
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    // reciprocal directions, kept finite so that rays parallel to a slab never make a NaN out of it
+    std::array<float, packet_size> ix, iy, iz;
+    auto reciprocal = [](float d) { return 1.0f / (std::abs(d) > 1e-8f ? d : std::copysign(1e-8f, d)); };
+    for (size_t lane = 0; lane < packet_size; ++lane) {
+        ix[lane] = reciprocal(packet.dx[lane]);
+        iy[lane] = reciprocal(packet.dy[lane]);
+        iz[lane] = reciprocal(packet.dz[lane]);
+    }
+
+#if defined(__SSE2__)
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps(1.0f);
+    const __m128 ox    = _mm_loadu_ps(packet.ox.data());
+    const __m128 oy    = _mm_loadu_ps(packet.oy.data());
+    const __m128 oz    = _mm_loadu_ps(packet.oz.data());
+    const __m128 dx    = _mm_loadu_ps(packet.dx.data());
+    const __m128 dy    = _mm_loadu_ps(packet.dy.data());
+    const __m128 dz    = _mm_loadu_ps(packet.dz.data());
+    const __m128 inv_x = _mm_loadu_ps(ix.data());
+    const __m128 inv_y = _mm_loadu_ps(iy.data());
+    const __m128 inv_z = _mm_loadu_ps(iz.data());
+    __m128 t           = _mm_loadu_ps(packet.t.data());
+    __m128 u           = _mm_loadu_ps(packet.u.data());
+    __m128 v           = _mm_loadu_ps(packet.v.data());
+#endif
+
+    // deep enough for any tree a median split builds
+    uint32_t stack[64];
+    size_t depth   = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        uint32_t index   = stack[--depth];
+        const Node &node = m_nodes[index];
+
+        // slab test: the ray enters the box before it leaves it, and before its `t`
+#if defined(__SSE2__)
+        __m128 x0    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.x), ox), inv_x);
+        __m128 x1    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.x), ox), inv_x);
+        __m128 y0    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.y), oy), inv_y);
+        __m128 y1    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.y), oy), inv_y);
+        __m128 z0    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.z), oz), inv_z);
+        __m128 z1    = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.z), oz), inv_z);
+        __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_min_ps(z0, z1));
+        __m128 leave = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_max_ps(z0, z1));
+        enter        = _mm_max_ps(enter, zero);
+        leave        = _mm_min_ps(leave, t);
+        if (_mm_movemask_ps(_mm_cmple_ps(enter, leave)) == 0) {
+            continue;
+        }
+#else
+        bool reached = false;
+        for (size_t lane = 0; lane < packet_size && ! reached; ++lane) {
+            float x0 = (node.min.x - packet.ox[lane]) * ix[lane], x1 = (node.max.x - packet.ox[lane]) * ix[lane];
+            float y0 = (node.min.y - packet.oy[lane]) * iy[lane], y1 = (node.max.y - packet.oy[lane]) * iy[lane];
+            float z0 = (node.min.z - packet.oz[lane]) * iz[lane], z1 = (node.max.z - packet.oz[lane]) * iz[lane];
+            float enter = std::max({std::min(x0, x1), std::min(y0, y1), std::min(z0, z1), 0.0f});
+            float leave = std::min({std::max(x0, x1), std::max(y0, y1), std::max(z0, z1), packet.t[lane]});
+            reached     = enter <= leave;
+        }
+        if (! reached) {
+            continue;
+        }
+#endif
+
+        if (node.count == 0) {
+            // the child on the side the first ray comes from goes first, its hits cut the search of the other one
+            bool reverse   = (node.axis == 0 ? packet.dx[0] : node.axis == 1 ? packet.dy[0] : packet.dz[0]) < 0.0f;
+            stack[depth++] = reverse ? index + 1 : node.first;
+            stack[depth++] = reverse ? node.first : index + 1;
+            continue;
+        }
+
+        // Möller-Trumbore, both faces of every triangle hit
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const glm::vec3 &v0 = m_v0[i], &e1 = m_e1[i], &e2 = m_e2[i];
+#if defined(__SSE2__)
+            __m128 e1x = _mm_set1_ps(e1.x), e1y = _mm_set1_ps(e1.y), e1z = _mm_set1_ps(e1.z);
+            __m128 e2x = _mm_set1_ps(e2.x), e2y = _mm_set1_ps(e2.y), e2z = _mm_set1_ps(e2.z);
+
+            __m128 px  = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+            __m128 py  = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+            __m128 pz  = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+            __m128 inv = _mm_div_ps(one, dot(e1x, e1y, e1z, px, py, pz));
+
+            __m128 sx    = _mm_sub_ps(ox, _mm_set1_ps(v0.x));
+            __m128 sy    = _mm_sub_ps(oy, _mm_set1_ps(v0.y));
+            __m128 sz    = _mm_sub_ps(oz, _mm_set1_ps(v0.z));
+            __m128 hit_u = _mm_mul_ps(dot(sx, sy, sz, px, py, pz), inv);
+
+            __m128 qx    = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+            __m128 qy    = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+            __m128 qz    = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+            __m128 hit_v = _mm_mul_ps(dot(dx, dy, dz, qx, qy, qz), inv);
+            __m128 hit_t = _mm_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), inv);
+
+            // a null determinant makes infinities or NaNs, which fail the comparisons
+            __m128 hit = _mm_and_ps(_mm_cmpge_ps(hit_u, zero), _mm_cmpge_ps(hit_v, zero));
+            hit        = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(hit_u, hit_v), one));
+            hit        = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(hit_t, _mm_set1_ps(t_min)), _mm_cmplt_ps(hit_t, t)));
+            int mask   = _mm_movemask_ps(hit);
+            if (mask == 0) {
+                continue;
+            }
+            // occluded rays are done, they leave the packet
+            t = _mm_or_ps(_mm_and_ps(hit, any ? _mm_set1_ps(-1.0f) : hit_t), _mm_andnot_ps(hit, t));
+            u = _mm_or_ps(_mm_and_ps(hit, hit_u), _mm_andnot_ps(hit, u));
+            v = _mm_or_ps(_mm_and_ps(hit, hit_v), _mm_andnot_ps(hit, v));
+            for (; mask != 0; mask &= mask - 1) {
+                packet.triangle[__builtin_ctz(mask)] = m_ids[i];
+            }
+#else
+            for (size_t lane = 0; lane < packet_size; ++lane) {
+                glm::vec3 d = packet.direction(lane), s = packet.origin(lane) - v0;
+                glm::vec3 p = glm::cross(d, e2), q = glm::cross(s, e1);
+                float inv   = 1.0f / glm::dot(e1, p);
+                float hit_u = glm::dot(s, p) * inv, hit_v = glm::dot(d, q) * inv, hit_t = glm::dot(e2, q) * inv;
+                bool inside = hit_u >= 0.0f && hit_v >= 0.0f && hit_u + hit_v <= 1.0f;
+                if (inside && hit_t > t_min && hit_t < packet.t[lane]) {
+                    packet.t[lane]        = any ? -1.0f : hit_t;
+                    packet.u[lane]        = hit_u;
+                    packet.v[lane]        = hit_v;
+                    packet.triangle[lane] = m_ids[i];
+                }
+            }
+#endif
+        }
+
+#if defined(__SSE2__)
+        if (any && _mm_movemask_ps(_mm_cmpge_ps(t, zero)) == 0) {
+            break;
+        }
+#else
+        if (any && std::all_of(packet.t.begin(), packet.t.end(), [](float t) { return t < 0.0f; })) {
+            break;
+        }
+#endif
+    }
+
+#if defined(__SSE2__)
+    _mm_storeu_ps(packet.t.data(), t);
+    _mm_storeu_ps(packet.u.data(), u);
+    _mm_storeu_ps(packet.v.data(), v);
+#endif
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// rays traced together, one per SIMD lane
+constexpr static size_t packet_size = 4;
+
+// Structure of arrays of `packet_size` rays. Lanes with a negative `t` are inactive, they never hit anything.
+struct RayPacket {
+    std::array<float, packet_size> ox, oy, oz;
+    std::array<float, packet_size> dx, dy, dz;
+    // farthest distance searched along each ray, that of the hit once traced
+    std::array<float, packet_size> t;
+    // triangle hit, -1 for none, and the barycentric coordinates of the hit on its second and third corners
+    std::array<int, packet_size> triangle;
+    std::array<float, packet_size> u, v;
+
+    void set(size_t lane, glm::vec3 origin, glm::vec3 direction, float far);
+    void deactivate(size_t lane);
+
+    glm::vec3 origin(size_t lane) const { return {ox[lane], oy[lane], oz[lane]}; }
+    glm::vec3 direction(size_t lane) const { return {dx[lane], dy[lane], dz[lane]}; }
+};
+
+// Bounding volume hierarchy over a triangle soup, built once on the CPU. Nodes split their triangles in two halves at
+// the median of their centroids along the longest axis, down to leaves of `leaf_size` triangles at most. Packets of
+// rays walk it together: every node box and every leaf triangle is tested against all the lanes at once (SSE2), and a
+// node is skipped once no lane reaches it.
+class Bvh {
+  public:
+    constexpr static size_t leaf_size = 4;
+
+    // every three consecutive corners make a triangle, identified by its index in the list from there on
+    explicit Bvh(const std::vector<glm::vec3> &corners);
+
+    // closest hit of every active ray within its `t`
+    void intersect(RayPacket &packet) const;
+    // whether anything lies within `t` of every active ray: `triangle` is the first hit found rather than the closest,
+    // `t`, `u` and `v` are left undefined
+    void occluded(RayPacket &packet) const;
+
+    size_t size() const { return m_ids.size(); }
+    size_t nodes() const { return m_nodes.size(); }
+
+  private:
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        // leaves: their triangles; other nodes: the second child, the first one follows them, and the split axis
+        uint32_t first;
+        uint32_t count;
+        uint32_t axis;
+    };
+
+    std::vector<Node> m_nodes;
+    // triangles in leaf order, as their first corner and their two edges from it
+    std::vector<glm::vec3> m_v0, m_e1, m_e2;
+    std::vector<int> m_ids;
+
+    // node for the triangles of `order` in [`begin`, `end`), after its children
+    uint32_t build(std::vector<uint32_t> &order, const std::vector<glm::vec3> &centroids,
+        const std::vector<glm::vec3> &corners, size_t begin, size_t end);
+    template <bool any> void traverse(RayPacket &packet) const;
+};
@@ -27,3 +27,18 @@ void Camera::euler(glm::vec3 euler) {
     m_front = front_from_euler(m_euler);
     m_up    = up_from_euler(m_euler);
 }
+
+void Camera::look_at(glm::vec3 target) {
+    glm::vec3 front = glm::normalize(target - m_position);
+    euler({std::asin(front.y), std::atan2(front.z, front.x), m_euler.z});
+}
+
+CameraStd140 std140(const Camera &camera, const glm::mat4 &projection) {
+    glm::mat4 view = camera.view();
+    return {
+        .view            = view,
+        .projection      = projection,
+        .view_projection = projection * view,
+        .view_position   = glm::vec4(camera.position(), 1.0f),
+    };
+}
@@ -12,6 +12,7 @@ class Camera {
     void fov(float fov) { m_fov = fov; }
     void position(glm::vec3 position) { m_position = position; }
     void euler(glm::vec3 euler);
+    void look_at(glm::vec3 target);
 
     float fov() const { return m_fov; }
 
@@ -30,3 +31,16 @@ class Camera {
     glm::vec3 m_front;
     glm::vec3 m_up;
 };
+
+constexpr static unsigned int camera_binding = 2;
+
+// std140 mirror of the `Camera` uniform block in res/camera.glsl
+struct CameraStd140 {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec4 view_position;
+};
+static_assert(sizeof(CameraStd140) == 208);
+
+CameraStd140 std140(const Camera &camera, const glm::mat4 &projection);
@@ -38,12 +38,24 @@ void Control::process_input(GLFWwindow *window, int key, int, int action, int) {
         control->m_flashlight = ! control->m_flashlight;
     }
 
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        control->m_lightmap = ! control->m_lightmap;
+    }
+
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        control->m_draw_path = DrawPath(((int) control->m_draw_path + 1) % (int) DrawPath::COUNT);
+    }
+
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        control->m_shading = Shading(((int) control->m_shading + 1) % (int) Shading::COUNT);
+    }
+
     if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) {
         control->m_pause = ! control->m_pause;
     }
 
     if (key == GLFW_KEY_N && action == GLFW_PRESS) {
-        control->m_light_count = std::min(control->light_count() + 1, 8);
+        control->m_light_count = control->light_count() + 1;
     }
 
     if (key == GLFW_KEY_M && action == GLFW_PRESS) {
@@ -8,6 +8,10 @@
 
 #include "camera.hpp"
 
+enum class DrawPath { NAIVE, INSTANCED, INDIRECT, COUNT };
+// lighting computed while drawing the cubes (forward) or afterwards from a G-buffer (deferred)
+enum class Shading { FORWARD, DEFERRED, COUNT };
+
 class Control {
   public:
     Control(Control &) = delete;
@@ -23,10 +27,17 @@ class Control {
     glm::vec2 last {0.0f, 0.0f};
 
     void movement_direction(glm::vec3 direction) { m_movement_direction = direction; }
+    void draw_path(DrawPath draw_path) { m_draw_path = draw_path; }
+    void shading(Shading shading) { m_shading = shading; }
+    void light_count(int light_count) { m_light_count = light_count; }
+    void lightmap(bool lightmap) { m_lightmap = lightmap; }
 
     bool pause() { return m_pause; }
     bool flashlight() { return m_flashlight; }
     int light_count() { return m_light_count; }
+    bool lightmap() { return m_lightmap; }
+    DrawPath draw_path() { return m_draw_path; }
+    Shading shading() { return m_shading; }
     const glm::vec3 &movement_direction() { return m_movement_direction; }
 
   protected:
@@ -37,9 +48,12 @@ class Control {
   private:
     bool m_pause {false};
     bool m_flashlight {false};
+    bool m_lightmap {false};
     bool m_first_mouse_event {true};
 
     int m_light_count {0};
+    DrawPath m_draw_path {DrawPath::NAIVE};
+    Shading m_shading {Shading::FORWARD};
     std::array<int, 4> m_wsad {0, 0, 0, 0};
     glm::vec3 m_movement_direction {0.0f, 0.0f, 0.0f};
 
@@ -0,0 +1,95 @@
+#include "frame_log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
+static std::string column(Pass pass) {
+    std::string name = pass_name(pass);
+    std::replace(name.begin(), name.end(), ' ', '_');
+    return name + "_ms";
+}
+
+static std::string escaped(const std::string &str) {
+    std::string out = {};
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+static double total(const GpuTimer::Times &times) {
+    return std::accumulate(times.pass_ms.begin(), times.pass_ms.end(), 0.0);
+}
+
+static void write_csv(std::ofstream &file, const std::vector<FrameRecord> &frames) {
+    file << "frame,cpu_ms,gpu_ms";
+    for (size_t pass = 0; pass < GpuTimer::passes; ++pass) {
+        file << "," << column(static_cast<Pass>(pass));
+    }
+    file << "\n";
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameRecord &frame = frames[i];
+        file << i << "," << frame.cpu_ms << ",";
+        if (frame.gpu.has_value()) {
+            file << total(frame.gpu.value());
+        }
+        for (size_t pass = 0; pass < GpuTimer::passes; ++pass) {
+            file << ",";
+            if (frame.gpu.has_value()) {
+                file << frame.gpu->pass_ms[pass];
+            }
+        }
+        file << "\n";
+    }
+}
+
+static void write_json(std::ofstream &file, const RunInfo &info, const std::vector<FrameRecord> &frames) {
+    file << "{\n";
+    for (const auto &[key, value] : info) {
+        file << "  \"" << escaped(key) << "\": \"" << escaped(value) << "\",\n";
+    }
+    file << "  \"passes\": [";
+    for (size_t pass = 0; pass < GpuTimer::passes; ++pass) {
+        file << (pass > 0 ? ", " : "") << "\"" << pass_name(static_cast<Pass>(pass)) << "\"";
+    }
+    file << "],\n  \"frames\": [\n";
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const FrameRecord &frame = frames[i];
+        file << "    {\"frame\": " << i << ", \"cpu_ms\": " << frame.cpu_ms << ", ";
+        if (frame.gpu.has_value()) {
+            file << "\"gpu_ms\": " << total(frame.gpu.value()) << ", \"pass_ms\": [";
+            for (size_t pass = 0; pass < GpuTimer::passes; ++pass) {
+                file << (pass > 0 ? ", " : "") << frame.gpu->pass_ms[pass];
+            }
+            file << "]}";
+        } else {
+            file << "\"gpu_ms\": null, \"pass_ms\": null}";
+        }
+        file << (i + 1 < frames.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+}
+
+Error write_frames(const std::filesystem::path &path, const RunInfo &info, const std::vector<FrameRecord> &frames) {
+    std::ofstream file(path);
+    if (! file) {
+        return wrap("could not open '" + path.string() + "' for writing");
+    }
+
+    if (path.extension() == ".json") {
+        write_json(file, info, frames);
+    } else {
+        write_csv(file, frames);
+    }
+
+    if (! file) {
+        return wrap("could not write '" + path.string() + "'");
+    }
+    return {};
+}
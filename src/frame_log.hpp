@@ -0,0 +1,22 @@
+#pragma once
+
+#include "error.hpp"
+#include "gpu_timer.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct FrameRecord {
+    double cpu_ms                      = 0.0;
+    std::optional<GpuTimer::Times> gpu = {};
+};
+
+// description of the run (renderer, scene...) as key value pairs, only written to JSON files
+using RunInfo = std::vector<std::pair<std::string, std::string>>;
+
+// per-frame times of a headless run, as JSON if `path` ends with .json, as CSV otherwise; GPU times dropped by the
+// timer are left empty (CSV) or null (JSON)
+Error write_frames(const std::filesystem::path &path, const RunInfo &info, const std::vector<FrameRecord> &frames);
@@ -0,0 +1,43 @@
+#include "framebuffer.hpp"
+
+#include <glad/glad.h>
+
+#include <sstream>
+
+Framebuffer::Framebuffer(int width, int height) {
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_ID);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer() {
+    glDeleteFramebuffers(1, &m_ID);
+    glDeleteRenderbuffers(1, &m_depth);
+    glDeleteRenderbuffers(1, &m_color);
+}
+
+void Framebuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, m_ID); }
+
+void Framebuffer::unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+Error Framebuffer::status() const {
+    bind();
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::ostringstream oss;
+        oss << "incomplete framebuffer, status 0x" << std::hex << status;
+        return wrap(oss.str());
+    }
+    return {};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "error.hpp"
+
+// offscreen render target: a color and a depth stencil renderbuffer
+class Framebuffer {
+  public:
+    Framebuffer(int width, int height);
+    ~Framebuffer();
+
+    void bind() const;
+    void unbind() const;
+
+    Error status() const;
+
+  private:
+    unsigned int m_ID;
+    unsigned int m_color;
+    unsigned int m_depth;
+};
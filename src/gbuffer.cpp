@@ -0,0 +1,83 @@
+#include "gbuffer.hpp"
+
+#include <glad/glad.h>
+
+#include <sstream>
+
+#include "state_cache.hpp"
+
+// positions keep full precision, normals and colors do with less
+constexpr static std::array<unsigned int, 4> formats = {GL_RGBA32F, GL_RGBA16F, GL_RGBA8, GL_RGBA8};
+
+GBuffer::GBuffer(int width, int height) : m_width(width), m_height(height) {
+    glGenTextures(m_textures.size(), m_textures.data());
+    for (size_t i = 0; i < attachments; ++i) {
+        // read back texel by texel, never filtered
+        StateCache::bind_texture(GL_TEXTURE0 + gbuffer_unit + i, GL_TEXTURE_2D, m_textures[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_ID);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+    std::array<unsigned int, attachments> buffers = {};
+    for (size_t i = 0; i < attachments; ++i) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_textures[i], 0);
+        buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glDrawBuffers(buffers.size(), buffers.data());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GBuffer::~GBuffer() {
+    glDeleteFramebuffers(1, &m_ID);
+    glDeleteRenderbuffers(1, &m_depth);
+    for (unsigned int texture : m_textures) {
+        StateCache::forget_texture(texture);
+    }
+    glDeleteTextures(m_textures.size(), m_textures.data());
+}
+
+void GBuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, m_ID); }
+
+void GBuffer::unbind() const { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+void GBuffer::clear() const {
+    constexpr float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < attachments; ++i) {
+        glClearBufferfv(GL_COLOR, i, zero);
+    }
+    glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+}
+
+void GBuffer::bind_textures() const {
+    for (size_t i = 0; i < attachments; ++i) {
+        StateCache::bind_texture(GL_TEXTURE0 + gbuffer_unit + i, GL_TEXTURE_2D, m_textures[i]);
+    }
+}
+
+void GBuffer::blit_depth() const {
+    int draw = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ID);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, draw);
+}
+
+Error GBuffer::status() const {
+    bind();
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::ostringstream oss;
+        oss << "incomplete G-buffer, status 0x" << std::hex << status;
+        return wrap(oss.str());
+    }
+    return {};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "error.hpp"
+
+// first of the texture units the attachments are read from, mirrored by the sampler bindings of res/deferred.frag
+constexpr static unsigned int gbuffer_unit = 2;
+
+// Render target of the geometry pass of deferred shading, laid out by res/gbuffer.frag: world position, normal and
+// shininess, diffuse and specular colors. The depth stencil buffer has the format of the default framebuffer's so that
+// it can be blitted to it.
+class GBuffer {
+  public:
+    GBuffer(int width, int height);
+    ~GBuffer();
+
+    void bind() const;
+    void unbind() const;
+
+    // every color attachment to 0, which tells the background apart, and the depth to 1
+    void clear() const;
+    // the color attachments, from `gbuffer_unit` on
+    void bind_textures() const;
+    // copies the depth buffer to the framebuffer bound for drawing
+    void blit_depth() const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    Error status() const;
+
+    GBuffer(const GBuffer &other)            = delete;
+    GBuffer &operator=(const GBuffer &other) = delete;
+
+  private:
+    constexpr static size_t attachments = 4;
+
+    int m_width;
+    int m_height;
+
+    unsigned int m_ID;
+    std::array<unsigned int, attachments> m_textures;
+    unsigned int m_depth;
+};
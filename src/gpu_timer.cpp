@@ -0,0 +1,122 @@
+#include "gpu_timer.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+std::string pass_name(Pass pass) {
+    switch (pass) {
+    case Pass::SHADOWS:
+        return "shadow maps";
+    case Pass::CUBES:
+        return "cubes";
+    case Pass::SHADING:
+        return "deferred shading";
+    case Pass::LIGHTS:
+        return "light proxies";
+    case Pass::LINES:
+        return "axis lines";
+    default:
+        return "unknown";
+    }
+}
+
+GpuTimer::GpuTimer() {
+    for (QuerySet &set : m_sets) {
+        glGenQueries(set.queries.size(), set.queries.data());
+    }
+}
+
+GpuTimer::~GpuTimer() {
+    for (QuerySet &set : m_sets) {
+        glDeleteQueries(set.queries.size(), set.queries.data());
+    }
+}
+
+void GpuTimer::begin(Pass pass) {
+    glQueryCounter(m_sets[m_frame].queries[2 * static_cast<size_t>(pass)], GL_TIMESTAMP);
+}
+
+void GpuTimer::end(Pass pass) {
+    QuerySet &set = m_sets[m_frame];
+    glQueryCounter(set.queries[2 * static_cast<size_t>(pass) + 1], GL_TIMESTAMP);
+    set.recorded[static_cast<size_t>(pass)] = true;
+}
+
+std::optional<GpuTimer::Times> GpuTimer::frame() {
+    m_sets[m_frame].frame = m_frames++;
+    m_frame               = (m_frame + 1) % frames;
+    return collect(m_sets[m_frame]);
+}
+
+std::vector<GpuTimer::Times> GpuTimer::flush() {
+    glFinish();
+
+    std::vector<Times> times = {};
+    for (unsigned int i = 1; i < frames; ++i) {
+        if (std::optional<Times> frame = collect(m_sets[(m_frame + i) % frames]); frame.has_value()) {
+            times.push_back(frame.value());
+        }
+    }
+    return times;
+}
+
+std::optional<GpuTimer::Times> GpuTimer::collect(QuerySet &set) {
+    Times times   = {set.frame, {}};
+    bool recorded = false;
+    bool complete = true;
+
+    for (size_t pass = 0; pass < passes; ++pass) {
+        if (! set.recorded[pass]) {
+            continue;
+        }
+        set.recorded[pass] = false;
+        recorded           = true;
+
+        // the end timestamp lands last, its availability implies the begin one
+        int available = GL_FALSE;
+        glGetQueryObjectiv(set.queries[2 * pass + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) {
+            m_dropped += 1;
+            complete = false;
+            continue;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 stop  = 0;
+        glGetQueryObjectui64v(set.queries[2 * pass], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(set.queries[2 * pass + 1], GL_QUERY_RESULT, &stop);
+
+        Samples &samples    = m_samples[pass];
+        times.pass_ms[pass] = (stop - start) / 1e6;
+        if (samples.ms.size() < window) {
+            samples.ms.push_back(times.pass_ms[pass]);
+        } else {
+            samples.ms[samples.next] = times.pass_ms[pass];
+        }
+        samples.next = (samples.next + 1) % window;
+    }
+
+    if (! recorded || ! complete) {
+        return {};
+    }
+    return times;
+}
+
+GpuTimer::Summary GpuTimer::summary(Pass pass) const {
+    std::vector<double> ms = m_samples[static_cast<size_t>(pass)].ms;
+    if (ms.empty()) {
+        return {};
+    }
+
+    std::sort(ms.begin(), ms.end());
+    size_t p99 = std::min(ms.size() - 1, static_cast<size_t>(std::ceil(0.99 * ms.size())) - 1);
+    return {
+        ms.size(),
+        ms.front(),
+        std::accumulate(ms.begin(), ms.end(), 0.0) / ms.size(),
+        ms[p99],
+    };
+}
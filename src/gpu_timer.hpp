@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+// SHADOWS renders the stale shadow maps; in deferred shading, CUBES fills the G-buffer and SHADING lights it
+enum class Pass { SHADOWS, CUBES, SHADING, LIGHTS, LINES, COUNT };
+
+std::string pass_name(Pass pass);
+
+// GL_TIMESTAMP queries around each pass. Query sets are recycled over `frames` frames and a result is only read once
+// available, so collecting never stalls; a result still pending when its set comes back is dropped.
+class GpuTimer {
+  public:
+    constexpr static unsigned int frames = 3;
+    // samples kept per pass for the rolling statistics
+    constexpr static size_t window = 256;
+    constexpr static size_t passes = static_cast<size_t>(Pass::COUNT);
+
+    // gpu time of every pass of one frame, 0 for the passes it did not record
+    struct Times {
+        unsigned int frame                 = 0;
+        std::array<double, passes> pass_ms = {};
+    };
+
+    struct Summary {
+        size_t samples = 0;
+        double min_ms  = 0.0;
+        double avg_ms  = 0.0;
+        double p99_ms  = 0.0;
+    };
+
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin(Pass pass);
+    void end(Pass pass);
+    // closes the frame being recorded and collects the results of the oldest one, if they are all available
+    std::optional<Times> frame();
+    // waits for the GPU and collects the frames still in flight
+    std::vector<Times> flush();
+
+    Summary summary(Pass pass) const;
+    unsigned int dropped() const { return m_dropped; }
+
+  private:
+    struct QuerySet {
+        unsigned int frame = 0;
+
+        // begin and end timestamps of each pass
+        std::array<unsigned int, 2 * passes> queries = {};
+        std::array<bool, passes> recorded            = {};
+    };
+
+    struct Samples {
+        std::vector<double> ms = {};
+        size_t next            = 0;
+    };
+
+    std::optional<Times> collect(QuerySet &set);
+
+    std::array<QuerySet, frames> m_sets   = {};
+    std::array<Samples, passes> m_samples = {};
+    unsigned int m_frame                  = 0;
+    unsigned int m_frames                 = 0;
+    unsigned int m_dropped                = 0;
+};
@@ -0,0 +1,84 @@
+#include "headless.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+static EGLDisplay display() {
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display != nullptr) {
+            return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static std::string egl_error(const std::string &call) {
+    std::ostringstream oss;
+    oss << call << " failed with EGL error 0x" << std::hex << eglGetError();
+    return oss.str();
+}
+
+std::pair<std::unique_ptr<HeadlessContext>, Error> HeadlessContext::create(int major, int minor) {
+    EGLDisplay egl_display = display();
+    if (egl_display == EGL_NO_DISPLAY || ! eglInitialize(egl_display, nullptr, nullptr)) {
+        return {nullptr, wrap(egl_error("eglInitialize"))};
+    }
+
+    if (! eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(egl_display);
+        return {nullptr, wrap(egl_error("eglBindAPI"))};
+    }
+
+    // no surface is ever created, rendering goes to framebuffer objects; the default surface type (window) would
+    // rule out every config of the surfaceless platform
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE,
+        EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE,
+        EGL_OPENGL_BIT,
+        EGL_NONE,
+    };
+    EGLConfig config                 = nullptr;
+    EGLint count                     = 0;
+    if (! eglChooseConfig(egl_display, config_attributes, &config, 1, &count) || count == 0) {
+        eglTerminate(egl_display);
+        return {nullptr, wrap(egl_error("eglChooseConfig"))};
+    }
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,
+        major,
+        EGL_CONTEXT_MINOR_VERSION,
+        minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLContext context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT) {
+        eglTerminate(egl_display);
+        return {nullptr, wrap(egl_error("eglCreateContext"))};
+    }
+
+    if (! eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        eglDestroyContext(egl_display, context);
+        eglTerminate(egl_display);
+        return {nullptr, wrap(egl_error("eglMakeCurrent"))};
+    }
+
+    return {std::unique_ptr<HeadlessContext>(new HeadlessContext(egl_display, context)), Error {}};
+}
+
+HeadlessContext::~HeadlessContext() {
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+}
+
+void *HeadlessContext::proc_address(const char *name) { return (void *) eglGetProcAddress(name); }
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "error.hpp"
+
+#include <memory>
+#include <utility>
+
+// OpenGL core context with no window nor display, made current on creation. Relies on EGL_MESA_platform_surfaceless
+// when available (Mesa, llvmpipe included) and falls back on the default EGL display.
+class HeadlessContext {
+  public:
+    static std::pair<std::unique_ptr<HeadlessContext>, Error> create(int major, int minor);
+    ~HeadlessContext();
+
+    // to be handed to gladLoadGLLoader
+    static void *proc_address(const char *name);
+
+  private:
+    HeadlessContext(void *display, void *context) : m_display(display), m_context(context) {}
+
+    void *m_display;
+    void *m_context;
+};
@@ -1,15 +1,19 @@
 #include "index_buffer.hpp"
+#include "state_cache.hpp"
 
 #include <glad/glad.h>
 
 IndexBuffer::IndexBuffer(std::vector<unsigned int> &&data) : m_count(data.size()) {
     glGenBuffers(1, &m_ID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
+    StateCache::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_count * sizeof(unsigned int), data.data(), GL_STATIC_DRAW);
 }
 
-IndexBuffer::~IndexBuffer() { glDeleteBuffers(1, &m_ID); }
+IndexBuffer::~IndexBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
 
-void IndexBuffer::bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ID); }
+void IndexBuffer::bind() const { StateCache::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ID); }
 
-void IndexBuffer::unbind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
+void IndexBuffer::unbind() const { StateCache::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
@@ -0,0 +1,41 @@
+#include "indirect_buffer.hpp"
+#include "state_cache.hpp"
+
+#include <glad/glad.h>
+
+DrawElementsIndirectCommand indirect_command(
+    const PooledMesh &mesh, unsigned int base_instance, unsigned int instance_count) {
+    return {mesh.count, instance_count, mesh.first_index, mesh.base_vertex, base_instance};
+}
+
+IndirectBuffer::IndirectBuffer(std::vector<DrawElementsIndirectCommand> &&commands) : m_count(commands.size()) {
+    glGenBuffers(1, &m_ID);
+    StateCache::bind_buffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER,
+        commands.size() * sizeof(DrawElementsIndirectCommand),
+        commands.data(),
+        GL_DYNAMIC_DRAW);
+}
+
+IndirectBuffer::~IndirectBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void IndirectBuffer::bind() const { StateCache::bind_buffer(GL_DRAW_INDIRECT_BUFFER, m_ID); }
+
+void IndirectBuffer::unbind() const { StateCache::bind_buffer(GL_DRAW_INDIRECT_BUFFER, 0); }
+
+void IndirectBuffer::write(size_t i, const DrawElementsIndirectCommand &command) const {
+    StateCache::bind_buffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, i * sizeof(command), sizeof(command), &command);
+}
+
+void IndirectBuffer::draw(Primitive primitive, size_t first, size_t count) const {
+    StateCache::bind_buffer(GL_DRAW_INDIRECT_BUFFER, m_ID);
+    glMultiDrawElementsIndirect(primitive,
+        GL_UNSIGNED_INT,
+        (const void *) (first * sizeof(DrawElementsIndirectCommand)),
+        count,
+        sizeof(DrawElementsIndirectCommand));
+}
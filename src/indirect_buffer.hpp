@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh_pool.hpp"
+#include "primitives.hpp"
+
+constexpr static unsigned int objects_binding = 1;
+
+// layout fixed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instance_count;
+    unsigned int first_index;
+    int base_vertex;
+    unsigned int base_instance;
+};
+
+DrawElementsIndirectCommand indirect_command(
+    const PooledMesh &mesh, unsigned int base_instance, unsigned int instance_count = 1);
+
+// std430 mirror of `struct Object` in res/objects.glsl, indexed by gl_BaseInstance + gl_InstanceID
+struct ObjectStd430 {
+    glm::mat4 model {1.0f};
+    glm::mat4 ti_model {1.0f};
+    // rgb replaces the vertex color when a is not 0
+    glm::vec4 color {0.0f, 0.0f, 0.0f, 0.0f};
+};
+static_assert(sizeof(ObjectStd430) == 144);
+
+class IndirectBuffer {
+  public:
+    IndirectBuffer(std::vector<DrawElementsIndirectCommand> &&commands);
+    ~IndirectBuffer();
+
+    void bind() const;
+    void unbind() const;
+
+    void write(size_t i, const DrawElementsIndirectCommand &command) const;
+
+    // draws commands [first, first + count) with a single glMultiDrawElementsIndirect; the vertex array of their pool
+    // must be bound
+    void draw(Primitive primitive, size_t first, size_t count) const;
+
+    unsigned int count() const { return m_count; }
+
+  private:
+    unsigned int m_ID;
+    unsigned int m_count;
+};
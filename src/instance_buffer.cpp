@@ -0,0 +1,30 @@
+#include "instance_buffer.hpp"
+#include "state_cache.hpp"
+
+#include <cstddef>
+
+std::vector<VertexLayout> instance_layouts() {
+    std::vector<VertexLayout> layouts;
+    for (size_t offset : {offsetof(Instance, model), offsetof(Instance, ti_model)}) {
+        for (size_t column = 0; column < 4; ++column) {
+            layouts.push_back(
+                {4, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void *) (offset + column * sizeof(glm::vec4))});
+        }
+    }
+    return layouts;
+}
+
+InstanceBuffer::InstanceBuffer(Instances &&instances) : m_count(instances.size()) {
+    glGenBuffers(1, &m_ID);
+    StateCache::bind_buffer(GL_ARRAY_BUFFER, m_ID);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STATIC_DRAW);
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void InstanceBuffer::bind() const { StateCache::bind_buffer(GL_ARRAY_BUFFER, m_ID); }
+
+void InstanceBuffer::unbind() const { StateCache::bind_buffer(GL_ARRAY_BUFFER, 0); }
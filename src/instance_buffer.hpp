@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.hpp"
+
+struct Instance {
+    glm::mat4 model {1.0f};
+    glm::mat4 ti_model {1.0f};
+};
+
+std::vector<VertexLayout> instance_layouts();
+
+using Instances = std::vector<Instance>;
+
+class InstanceBuffer {
+  public:
+    InstanceBuffer(Instances &&instances);
+    ~InstanceBuffer();
+
+    void bind() const;
+    void unbind() const;
+
+    unsigned int count() const { return m_count; }
+
+  private:
+    unsigned int m_ID;
+    unsigned int m_count;
+};
@@ -0,0 +1,244 @@
+#include "json.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+// nesting deeper than this is refused rather than recursed into
+constexpr static unsigned int max_depth = 256;
+
+static const Json null = {};
+
+class JsonParser {
+  public:
+    explicit JsonParser(std::string_view text) : m_text(text) {}
+
+    std::pair<Json, Error> document() {
+        Json json = {};
+        if (Error error = value(json, 0); error.has_value()) {
+            return {{}, error};
+        }
+        skip_space();
+        if (m_pos != m_text.size()) {
+            return {{}, fail("trailing characters")};
+        }
+        return {std::move(json), {}};
+    }
+
+  private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+
+    Error fail(const std::string &msg) const { return "malformed JSON at byte " + std::to_string(m_pos) + ": " + msg; }
+
+    void skip_space() {
+        while (m_pos < m_text.size() &&
+               (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+            m_pos++;
+        }
+    }
+
+    bool consume(std::string_view token) {
+        if (m_text.substr(m_pos, token.size()) != token) {
+            return false;
+        }
+        m_pos += token.size();
+        return true;
+    }
+
+    Error value(Json &json, unsigned int depth) {
+        if (depth > max_depth) {
+            return fail("nested too deep");
+        }
+        skip_space();
+        if (m_pos == m_text.size()) {
+            return fail("unexpected end");
+        }
+        switch (m_text[m_pos]) {
+        case '{':
+            return object(json, depth);
+        case '[':
+            return array(json, depth);
+        case '"':
+            json.type = Json::Type::STRING;
+            return string(json.string);
+        case 't':
+        case 'f':
+            json.type    = Json::Type::BOOLEAN;
+            json.boolean = m_text[m_pos] == 't';
+            return consume(json.boolean ? "true" : "false") ? Error {} : fail("unknown literal");
+        case 'n':
+            return consume("null") ? Error {} : fail("unknown literal");
+        default:
+            json.type = Json::Type::NUMBER;
+            return number(json.number);
+        }
+    }
+
+    Error object(Json &json, unsigned int depth) {
+        json.type = Json::Type::OBJECT;
+        m_pos++;
+        skip_space();
+        if (consume("}")) {
+            return {};
+        }
+        while (true) {
+            skip_space();
+            std::string key = {};
+            if (m_pos == m_text.size() || m_text[m_pos] != '"') {
+                return fail("expected a key");
+            }
+            if (Error error = string(key); error.has_value()) {
+                return error;
+            }
+            skip_space();
+            if (! consume(":")) {
+                return fail("expected ':'");
+            }
+            if (Error error = value(json.object[key], depth + 1); error.has_value()) {
+                return error;
+            }
+            skip_space();
+            if (consume("}")) {
+                return {};
+            }
+            if (! consume(",")) {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    Error array(Json &json, unsigned int depth) {
+        json.type = Json::Type::ARRAY;
+        m_pos++;
+        skip_space();
+        if (consume("]")) {
+            return {};
+        }
+        while (true) {
+            if (Error error = value(json.array.emplace_back(), depth + 1); error.has_value()) {
+                return error;
+            }
+            skip_space();
+            if (consume("]")) {
+                return {};
+            }
+            if (! consume(",")) {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    Error number(double &number) {
+        const char *first = m_text.data() + m_pos, *last = m_text.data() + m_text.size();
+        auto [end, error] = std::from_chars(first, last, number);
+        if (error != std::errc()) {
+            return fail("expected a value");
+        }
+        m_pos += end - first;
+        return {};
+    }
+
+    Error hex(uint32_t &code) {
+        const char *first = m_text.data() + m_pos, *last = first + std::min<size_t>(4, m_text.size() - m_pos);
+        auto [end, error] = std::from_chars(first, last, code, 16);
+        if (error != std::errc() || end != first + 4) {
+            return fail("malformed \\u escape");
+        }
+        m_pos += 4;
+        return {};
+    }
+
+    Error string(std::string &out) {
+        m_pos++;
+        while (m_pos < m_text.size()) {
+            char c = m_text[m_pos++];
+            if (c == '"') {
+                return {};
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_pos == m_text.size()) {
+                break;
+            }
+            switch (char escaped = m_text[m_pos++]) {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                uint32_t code = 0, low = 0;
+                if (Error error = hex(code); error.has_value()) {
+                    return error;
+                }
+                // characters past the basic plane come as a surrogate pair
+                if (code >= 0xd800 && code < 0xdc00 && consume("\\u")) {
+                    if (Error error = hex(low); error.has_value()) {
+                        return error;
+                    }
+                    if (low < 0xdc00 || low >= 0xe000) {
+                        return fail("malformed surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                }
+                utf8(code, out);
+                break;
+            }
+            default:
+                out += escaped;
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    static void utf8(uint32_t code, std::string &out) {
+        if (code < 0x80) {
+            out += char(code);
+        } else if (code < 0x800) {
+            out += char(0xc0 | code >> 6);
+            out += char(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            out += char(0xe0 | code >> 12);
+            out += char(0x80 | (code >> 6 & 0x3f));
+            out += char(0x80 | (code & 0x3f));
+        } else {
+            out += char(0xf0 | code >> 18);
+            out += char(0x80 | (code >> 12 & 0x3f));
+            out += char(0x80 | (code >> 6 & 0x3f));
+            out += char(0x80 | (code & 0x3f));
+        }
+    }
+};
+
+std::pair<Json, Error> Json::parse(std::string_view text) {
+    auto [json, error] = JsonParser(text).document();
+    if (error.has_value()) {
+        return {{}, wrap(error)};
+    }
+    return {std::move(json), {}};
+}
+
+const Json &Json::operator[](const std::string &key) const {
+    if (type != Type::OBJECT) {
+        return null;
+    }
+    auto found = object.find(key);
+    return found != object.end() ? found->second : null;
+}
+
+const Json &Json::operator[](size_t i) const {
+    return type == Type::ARRAY && i < array.size() ? array[i] : null;
+}
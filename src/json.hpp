@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "error.hpp"
+
+// JSON document, as much of it as the header of a glTF file needs: numbers are all doubles and lookups never fail,
+// they return null instead.
+struct Json {
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type     = Type::NUL;
+    bool boolean  = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::map<std::string, Json> object;
+
+    static std::pair<Json, Error> parse(std::string_view text);
+
+    // member `key` of an object
+    const Json &operator[](const std::string &key) const;
+    // element `i` of an array
+    const Json &operator[](size_t i) const;
+
+    bool is_null() const { return type == Type::NUL; }
+    // elements of an array, members of an object
+    size_t size() const { return type == Type::ARRAY ? array.size() : type == Type::OBJECT ? object.size() : 0; }
+    // `number`, or `fallback` for anything else than a number
+    double number_or(double fallback) const { return type == Type::NUMBER ? number : fallback; }
+};
@@ -0,0 +1,53 @@
+#include "light.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+float light_radius(const Light &light, float threshold) {
+    if (light.position.w == 0.0f) {
+        return std::numeric_limits<float>::max();
+    }
+
+    // solves constant + linear * d + quadratic * d^2 = 1 / threshold
+    float k = 1.0f / threshold - light.constant;
+    if (k <= 0.0f) {
+        return 0.0f;
+    }
+    if (light.quadratic > 0.0f) {
+        return (-light.linear + std::sqrt(light.linear * light.linear + 4.0f * light.quadratic * k)) /
+               (2.0f * light.quadratic);
+    }
+    if (light.linear > 0.0f) {
+        return k / light.linear;
+    }
+    return std::numeric_limits<float>::max();
+}
+
+float light_attenuation(const Light &light, float distance, float radius) {
+    // (1 - (d / r)^4)^2 leaves the light untouched up close and flattens it out at its radius
+    float ratio  = distance / radius;
+    float window = std::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+    return window * window / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+}
+
+LightStd430 std430(const Light &light) {
+    return {
+        .position = light.position,
+
+        .direction      = light.direction,
+        .is_directional = light.is_directional,
+
+        .ambient       = light.ambient,
+        .cut_off       = light.cut_off,
+        .diffuse       = light.diffuse,
+        .outer_cut_off = light.outer_cut_off,
+        .specular      = light.specular,
+        .constant      = light.constant,
+
+        .linear    = light.linear,
+        .quadratic = light.quadratic,
+        .radius    = light_radius(light),
+        .shadow    = light.shadow,
+    };
+}
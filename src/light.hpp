@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+struct Light {
+    glm::vec4 position = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    bool is_directional = false;
+    glm::vec3 direction = {0.0f, 0.0f, 0.0f};
+    float cut_off       = 0.0f;
+    float outer_cut_off = 0.0f;
+
+    glm::vec3 ambient  = {1.0f, 1.0f, 1.0f};
+    glm::vec3 diffuse  = {1.0f, 1.0f, 1.0f};
+    glm::vec3 specular = {1.0f, 1.0f, 1.0f};
+
+    float constant  = 1.0f;
+    float linear    = 0.0f;
+    float quadratic = 0.0f;
+
+    // map of the light in the `ShadowAtlas`, -1 when it casts no shadow
+    int shadow = -1;
+};
+
+// distance at which the attenuation of `light` falls to `threshold`, infinite for lights without falloff. Shading fades
+// the light out on the way so that it adds nothing past it, which bounds the lights at the scale of their attenuation
+// rather than at that of an 8 bits color.
+float light_radius(const Light &light, float threshold = 1.0f / 32.0f);
+// attenuation of `light` at `distance`, windowed to reach 0 at `radius`; mirrors `light_attenuation` in res/lights.glsl
+float light_attenuation(const Light &light, float distance, float radius);
+// stands for an infinite radius in light culling, squares to a finite float
+constexpr static float unbounded_radius = 1e15f;
+
+constexpr static unsigned int lights_binding = 0;
+
+// std430 mirror of `struct Light` in res/lights.glsl: every vec3 is followed by a scalar so that it fills its 16 bytes
+// slot.
+struct LightStd430 {
+    glm::vec4 position;
+
+    glm::vec3 direction;
+    int is_directional;
+
+    glm::vec3 ambient;
+    float cut_off;
+    glm::vec3 diffuse;
+    float outer_cut_off;
+    glm::vec3 specular;
+    float constant;
+
+    float linear;
+    float quadratic;
+    // `light_radius`, bounds the volume lit by the deferred shading pass
+    float radius;
+    int shadow;
+};
+static_assert(sizeof(LightStd430) == 96);
+
+// head of the `Lights` storage block, followed by its runtime sized array of `count` lights
+struct LightsStd430 {
+    int count;
+    int padding[3];
+    // the camera's spot light, outside of the array since it is never culled
+    LightStd430 flashlight;
+};
+static_assert(sizeof(LightsStd430) == 112);
+
+// bytes taken by the `Lights` block holding `count` lights
+constexpr size_t std430_size(size_t count) { return sizeof(LightsStd430) + count * sizeof(LightStd430); }
+
+LightStd430 std430(const Light &light);
@@ -0,0 +1,145 @@
+#include "light_clusters.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+// lanes tested at once, slices pad their lights to a multiple of it
+constexpr static size_t lanes = 4;
+
+LightClusters::LightClusters(ClusterDimensions dimensions, unsigned int threads)
+    : m_dimensions(dimensions), m_slices(dimensions.z), m_ranges(dimensions.x * dimensions.y * dimensions.z),
+      m_pool(threads) {}
+
+void LightClusters::assign(const std::vector<Light> &lights, size_t count, const Frustum &frustum) {
+    m_frustum = frustum;
+
+    count = std::min(count, lights.size());
+    m_x.resize(count);
+    m_y.resize(count);
+    m_z.resize(count);
+    m_radius.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        // directional lights reach every cluster from the eye
+        glm::vec4 position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        if (lights[i].position.w != 0.0f) {
+            position = frustum.view * lights[i].position;
+        }
+        m_x[i]      = position.x;
+        m_y[i]      = position.y;
+        m_z[i]      = position.z;
+        m_radius[i] = std::min(light_radius(lights[i]), unbounded_radius);
+    }
+
+    m_pool.run(m_dimensions.z, [this](size_t z) { assign_slice(z); });
+
+    // slices listed their lights with offsets of their own, laid end to end here
+    size_t tiles = m_dimensions.x * m_dimensions.y, total = 0;
+    for (unsigned int z = 0; z < m_dimensions.z; ++z) {
+        for (size_t i = z * tiles; i < (z + 1) * tiles; ++i) {
+            m_ranges[i].x += total;
+        }
+        total += m_slices[z].indices.size();
+    }
+    m_indices.resize(total);
+    auto output = m_indices.begin();
+    for (const Slice &slice : m_slices) {
+        output = std::copy(slice.indices.begin(), slice.indices.end(), output);
+    }
+}
+
+ClustersStd430 LightClusters::std430(glm::vec2 viewport) const {
+    float ratio = std::log(m_frustum.far / m_frustum.near);
+    return {
+        .dimensions = {m_dimensions.x, m_dimensions.y, m_dimensions.z, 0},
+        .scale      = {viewport, m_dimensions.z / ratio, m_dimensions.z * std::log(m_frustum.near) / ratio},
+    };
+}
+
+std::pair<glm::vec3, glm::vec3> LightClusters::bounds(
+    unsigned int x, unsigned int y, unsigned int z, const Frustum &frustum) const {
+    float tan_y = std::tan(0.5f * frustum.fov), tan_x = frustum.aspect * tan_y;
+    float ratio = frustum.far / frustum.near;
+    float near  = frustum.near * std::pow(ratio, (float) z / m_dimensions.z);
+    float far   = frustum.near * std::pow(ratio, (float) (z + 1) / m_dimensions.z);
+
+    // tile edges on the plane at distance 1, scaled by the depth of both ends of the slice
+    float x0 = (2.0f * x / m_dimensions.x - 1.0f) * tan_x, x1 = (2.0f * (x + 1) / m_dimensions.x - 1.0f) * tan_x;
+    float y0 = (2.0f * y / m_dimensions.y - 1.0f) * tan_y, y1 = (2.0f * (y + 1) / m_dimensions.y - 1.0f) * tan_y;
+    return {
+        {std::min(x0 * near, x0 * far), std::min(y0 * near, y0 * far), -far},
+        {std::max(x1 * near, x1 * far), std::max(y1 * near, y1 * far), -near},
+    };
+}
+
+void LightClusters::assign_slice(unsigned int z) {
+    Slice &slice = m_slices[z];
+    slice.candidates.clear();
+    slice.x.clear();
+    slice.y.clear();
+    slice.z.clear();
+    slice.radius.clear();
+    slice.indices.clear();
+
+    auto [first, last] = bounds(0, 0, z, m_frustum);
+    float near = -last.z, far = -first.z;
+    for (size_t i = 0; i < m_x.size(); ++i) {
+        float depth = -m_z[i];
+        if (depth + m_radius[i] >= near && depth - m_radius[i] <= far) {
+            slice.candidates.push_back(i);
+            slice.x.push_back(m_x[i]);
+            slice.y.push_back(m_y[i]);
+            slice.z.push_back(m_z[i]);
+            slice.radius.push_back(m_radius[i]);
+        }
+    }
+    // padding lanes sit far away with a null radius, they never touch a cluster
+    size_t count = slice.candidates.size(), padded = (count + lanes - 1) / lanes * lanes;
+    slice.x.resize(padded, unbounded_radius);
+    slice.y.resize(padded, unbounded_radius);
+    slice.z.resize(padded, unbounded_radius);
+    slice.radius.resize(padded, 0.0f);
+
+    size_t cluster = z * m_dimensions.x * m_dimensions.y;
+    for (unsigned int y = 0; y < m_dimensions.y; ++y) {
+        for (unsigned int x = 0; x < m_dimensions.x; ++x, ++cluster) {
+            auto [min, max] = bounds(x, y, z, m_frustum);
+            size_t offset   = slice.indices.size();
+
+            // sphere against box: squared distance from the center to the closest point of the box
+#if defined(__SSE2__)
+            const __m128 zero = _mm_setzero_ps();
+            __m128 min_x = _mm_set1_ps(min.x), min_y = _mm_set1_ps(min.y), min_z = _mm_set1_ps(min.z);
+            __m128 max_x = _mm_set1_ps(max.x), max_y = _mm_set1_ps(max.y), max_z = _mm_set1_ps(max.z);
+            for (size_t i = 0; i < padded; i += lanes) {
+                __m128 px = _mm_loadu_ps(&slice.x[i]), py = _mm_loadu_ps(&slice.y[i]), pz = _mm_loadu_ps(&slice.z[i]);
+                __m128 radius = _mm_loadu_ps(&slice.radius[i]);
+
+                __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, px), _mm_sub_ps(px, max_x)), zero);
+                __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, py), _mm_sub_ps(py, max_y)), zero);
+                __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, pz), _mm_sub_ps(pz, max_z)), zero);
+                __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+                for (int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(radius, radius))); mask != 0;
+                     mask &= mask - 1) {
+                    slice.indices.push_back(slice.candidates[i + __builtin_ctz(mask)]);
+                }
+            }
+#else
+            for (size_t i = 0; i < count; ++i) {
+                float dx = std::max({min.x - slice.x[i], slice.x[i] - max.x, 0.0f});
+                float dy = std::max({min.y - slice.y[i], slice.y[i] - max.y, 0.0f});
+                float dz = std::max({min.z - slice.z[i], slice.z[i] - max.z, 0.0f});
+                if (dx * dx + dy * dy + dz * dz <= slice.radius[i] * slice.radius[i]) {
+                    slice.indices.push_back(slice.candidates[i]);
+                }
+            }
+#endif
+            slice.indices.resize(std::min(slice.indices.size(), offset + max_cluster_lights));
+            m_ranges[cluster] = {offset, slice.indices.size() - offset};
+        }
+    }
+}
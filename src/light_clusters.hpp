@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "light.hpp"
+#include "worker_pool.hpp"
+
+constexpr static unsigned int clusters_binding       = 3;
+constexpr static unsigned int cluster_lights_binding = 4;
+// lights listed in a cluster at most, the first ones of the scene win and the others go dark in that cluster
+constexpr static size_t max_cluster_lights = 256;
+
+// view volume divided into clusters, looking down -z in view space
+struct Frustum {
+    glm::mat4 view;
+    // vertical field of view, in radians
+    float fov;
+    float aspect;
+    float near;
+    float far;
+};
+
+// clusters across the width and height of the viewport, and slices in depth
+struct ClusterDimensions {
+    unsigned int x = 16;
+    unsigned int y = 9;
+    unsigned int z = 24;
+};
+
+// std430 head of the `Clusters` storage block in res/clusters.glsl, followed by one (offset, count) pair per cluster
+struct ClustersStd430 {
+    glm::uvec4 dimensions;
+    // viewport width and height, depth slice scale and bias: slice = log(depth) * scale - bias
+    glm::vec4 scale;
+};
+static_assert(sizeof(ClustersStd430) == 32);
+
+// Clustered forward light assignment. The frustum is split into a grid of tiles on screen and exponential slices in
+// depth; every light is listed in the clusters its attenuation sphere touches, so that a fragment only shades the
+// lights of its own cluster, `max_cluster_lights` of them at most. Depth slices are shared out to a pool of threads,
+// each testing the sphere of several lights against a cluster at once.
+class LightClusters {
+  public:
+    LightClusters(ClusterDimensions dimensions = {}, unsigned int threads = std::thread::hardware_concurrency());
+
+    // lists the first `count` lights in every cluster of `frustum` they reach
+    void assign(const std::vector<Light> &lights, size_t count, const Frustum &frustum);
+
+    const ClusterDimensions &dimensions() const { return m_dimensions; }
+    size_t size() const { return m_ranges.size(); }
+    unsigned int threads() const { return m_pool.threads(); }
+
+    // (offset, count) in `indices` of the lights of each cluster, x varying fastest, then y, then z
+    const std::vector<glm::uvec2> &ranges() const { return m_ranges; }
+    const std::vector<uint32_t> &indices() const { return m_indices; }
+
+    ClustersStd430 std430(glm::vec2 viewport) const;
+    // view space box of cluster (`x`, `y`, `z`) of `frustum`
+    std::pair<glm::vec3, glm::vec3> bounds(
+        unsigned int x, unsigned int y, unsigned int z, const Frustum &frustum) const;
+
+    LightClusters(const LightClusters &other)            = delete;
+    LightClusters &operator=(const LightClusters &other) = delete;
+
+  private:
+    struct Slice {
+        // lights overlapping the slice in depth, structure of arrays padded to a whole number of SIMD lanes
+        std::vector<uint32_t> candidates;
+        std::vector<float> x, y, z, radius;
+
+        std::vector<uint32_t> indices;
+    };
+
+    ClusterDimensions m_dimensions;
+    Frustum m_frustum = {};
+
+    // view space lights of the current assignment
+    std::vector<float> m_x, m_y, m_z, m_radius;
+
+    std::vector<Slice> m_slices;
+    std::vector<glm::uvec2> m_ranges;
+    std::vector<uint32_t> m_indices;
+
+    WorkerPool m_pool;
+
+    void assign_slice(unsigned int z);
+};
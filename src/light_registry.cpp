@@ -0,0 +1,121 @@
+#include "light_registry.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+LightRegistry::Stats &LightRegistry::Stats::operator+=(const Stats &other) {
+    writes += other.writes;
+    bytes += other.bytes;
+    return *this;
+}
+
+LightRegistry::LightRegistry(size_t capacity)
+    : m_capacity(std::max(capacity, (size_t) 1)),
+      m_buffer(std::make_unique<StorageBuffer>(std430_size(m_capacity), lights_binding)) {}
+
+LightHandle LightRegistry::add(const Light &light) {
+    uint32_t index = m_slots.size();
+    if (m_free.empty()) {
+        m_slots.push_back(0);
+        m_generations.push_back(0);
+    } else {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+
+    m_slots[index] = m_lights.size();
+    m_handles.push_back(index);
+    m_lights.emplace_back();
+    m_packed.emplace_back();
+    m_dirty.push_back(true);
+    write(m_lights.size() - 1, light);
+
+    m_head_dirty = true;
+    m_revision++;
+    return {index, m_generations[index]};
+}
+
+void LightRegistry::remove(LightHandle handle) {
+    assert(contains(handle));
+
+    size_t slot = m_slots[handle.index], last = m_lights.size() - 1;
+    if (slot != last) {
+        m_lights[slot]           = m_lights[last];
+        m_packed[slot]           = m_packed[last];
+        m_dirty[slot]            = true;
+        m_handles[slot]          = m_handles[last];
+        m_slots[m_handles[slot]] = slot;
+    }
+    m_lights.pop_back();
+    m_packed.pop_back();
+    m_dirty.pop_back();
+    m_handles.pop_back();
+
+    // the handle goes stale, its index comes back with the next generation
+    m_generations[handle.index]++;
+    m_free.push_back(handle.index);
+
+    m_head_dirty = true;
+    m_revision++;
+}
+
+bool LightRegistry::contains(LightHandle handle) const {
+    return handle.index < m_generations.size() && m_generations[handle.index] == handle.generation;
+}
+
+const Light &LightRegistry::operator[](LightHandle handle) const {
+    assert(contains(handle));
+    return m_lights[m_slots[handle.index]];
+}
+
+void LightRegistry::flashlight(const Light &light) {
+    LightStd430 packed = std430(light);
+    if (std::memcmp(&packed, &m_flashlight, sizeof(LightStd430)) != 0) {
+        m_flashlight = packed;
+        m_head_dirty = true;
+    }
+}
+
+LightRegistry::Stats LightRegistry::upload() {
+    Stats stats = {};
+
+    if (m_lights.size() > m_capacity) {
+        // twice the room needed, everything is written again
+        m_capacity = 2 * m_lights.size();
+        m_buffer   = std::make_unique<StorageBuffer>(std430_size(m_capacity), lights_binding);
+        std::fill(m_dirty.begin(), m_dirty.end(), true);
+        m_head_dirty = true;
+    }
+
+    if (m_head_dirty) {
+        LightsStd430 head = {.count = (int) m_lights.size(), .padding = {}, .flashlight = m_flashlight};
+        m_buffer->write(&head, sizeof(head));
+        stats.writes += 1;
+        stats.bytes += sizeof(head);
+        m_head_dirty = false;
+    }
+
+    for (size_t first = 0; first < m_dirty.size();) {
+        if (! m_dirty[first]) {
+            first++;
+            continue;
+        }
+        size_t last = first;
+        for (; last < m_dirty.size() && m_dirty[last]; ++last) {
+            m_dirty[last] = false;
+        }
+        size_t bytes = (last - first) * sizeof(LightStd430);
+        m_buffer->write(&m_packed[first], bytes, std430_size(first));
+        stats.writes += 1;
+        stats.bytes += bytes;
+        first = last;
+    }
+    return stats;
+}
+
+void LightRegistry::write(size_t slot, const Light &light) {
+    m_lights[slot] = light;
+    m_packed[slot] = std430(light);
+    m_dirty[slot]  = true;
+}
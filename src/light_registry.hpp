@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "light.hpp"
+#include "storage_buffer.hpp"
+
+// names a light of a `LightRegistry` for as long as it is in it, whatever is added or removed around it
+struct LightHandle {
+    uint32_t index      = ~0u;
+    uint32_t generation = 0;
+};
+
+// Lights of the scene kept from frame to frame in the `Lights` storage block. The lights never change once added: they
+// are packed at the front of the block, a removal moving the last one into the hole, and handles find them wherever
+// they are. Only the lights added or moved since the previous upload are sent again, consecutive ones in a single
+// write.
+class LightRegistry {
+  public:
+    // writes made by `upload`
+    struct Stats {
+        unsigned int writes = 0;
+        size_t bytes        = 0;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+    // room for `capacity` lights to begin with, the storage grows past it
+    LightRegistry(size_t capacity);
+
+    LightHandle add(const Light &light);
+    void remove(LightHandle handle);
+
+    const Light &operator[](LightHandle handle) const;
+
+    // the camera's spot light, written to the head of the block
+    void flashlight(const Light &light);
+
+    // packed in block order, to be culled
+    const std::vector<Light> &lights() const { return m_lights; }
+    size_t size() const { return m_lights.size(); }
+    // bumped whenever `lights` changes, the flashlight aside
+    unsigned int revision() const { return m_revision; }
+
+    // writes what changed since the previous call to the storage block
+    Stats upload();
+
+    LightRegistry(const LightRegistry &other)            = delete;
+    LightRegistry &operator=(const LightRegistry &other) = delete;
+
+  private:
+    std::vector<Light> m_lights;
+    std::vector<LightStd430> m_packed;
+    std::vector<bool> m_dirty;
+    // handle of the light in each slot
+    std::vector<uint32_t> m_handles;
+
+    // slot and generation of each handle, free handles are recycled with their next generation
+    std::vector<uint32_t> m_slots;
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_free;
+
+    LightStd430 m_flashlight = {};
+    bool m_head_dirty        = true;
+    unsigned int m_revision  = 0;
+
+    size_t m_capacity;
+    std::unique_ptr<StorageBuffer> m_buffer;
+
+    // `handle` names a light still in the registry
+    bool contains(LightHandle handle) const;
+    void write(size_t slot, const Light &light);
+};
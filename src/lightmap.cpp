@@ -0,0 +1,525 @@
+#include "lightmap.hpp"
+
+#include <glad/glad.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#define STBI_FAILURE_USERMSG
+#include <stb_image.h>
+#pragma GCC diagnostic pop
+
+#include "bvh.hpp"
+#include "object_lights.hpp"
+#include "primitives.hpp"
+#include "state_cache.hpp"
+#include "worker_pool.hpp"
+
+// atlas sides, within the GL_MAX_TEXTURE_SIZE every GL 4.6 implementation supports
+constexpr static unsigned int max_size = 16384;
+// rays leave surfaces from this far above them
+constexpr static float offset = 1e-3f;
+
+// head of the files written by `Lightmap::save`, followed by the irradiance of every texel
+struct LightmapHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t width;
+    uint32_t height;
+    uint32_t texels;
+    uint32_t tile_width;
+    uint32_t tile_height;
+    uint32_t columns;
+    uint32_t objects;
+    uint32_t samples;
+    uint32_t bounces;
+    uint32_t padding;
+};
+static_assert(sizeof(LightmapHeader) == 56);
+
+constexpr static char magic[4]    = {'L', 'M', 'A', 'P'};
+constexpr static uint32_t version = 2;
+
+// PCG32: a sequence of its own for every object, whichever thread bakes it
+class Random {
+  public:
+    explicit Random(uint64_t sequence) : m_increment(sequence << 1 | 1) {
+        next();
+        m_state += 0x853c49e6748fea9bull;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t state = m_state;
+        m_state        = state * 6364136223846793005ull + m_increment;
+        uint32_t xored = ((state >> 18) ^ state) >> 27;
+        uint32_t rot   = state >> 59;
+        return (xored >> rot) | (xored << ((-rot) & 31));
+    }
+
+    // in [0, 1)
+    float uniform() { return (next() >> 8) * 0x1p-24f; }
+
+  private:
+    uint64_t m_state = 0;
+    uint64_t m_increment;
+};
+
+// distributed as the cosine to `normal`, around which the basis is built without any branch (Duff et al. 2017)
+static glm::vec3 cosine_direction(glm::vec3 normal, Random &random) {
+    float phi = 2.0f * glm::pi<float>() * random.uniform(), r2 = random.uniform(), r = std::sqrt(r2);
+
+    float sign          = std::copysign(1.0f, normal.z);
+    float a             = -1.0f / (sign + normal.z);
+    float b             = normal.x * normal.y * a;
+    glm::vec3 tangent   = {1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x};
+    glm::vec3 bitangent = {b, sign + normal.y * normal.y * a, -normal.y};
+    return r * std::cos(phi) * tangent + r * std::sin(phi) * bitangent + std::sqrt(1.0f - r2) * normal;
+}
+
+glm::vec3 Albedo::operator()(glm::vec2 tex) const {
+    int x = (int) std::floor(tex.x * width) % width, y = (int) std::floor(tex.y * height) % height;
+    return texels[(y < 0 ? y + height : y) * width + (x < 0 ? x + width : x)];
+}
+
+std::pair<Albedo, Error> Albedo::from_file(const std::string &path) {
+    stbi_set_flip_vertically_on_load(false);
+
+    int width = 0, height = 0, n_channels = 0;
+    unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &n_channels, 3);
+    if (! pixels) {
+        return {{}, wrap(std::string(stbi_failure_reason()) + " " + path)};
+    }
+
+    Albedo albedo = {width, height, std::vector<glm::vec3>(width * height)};
+    for (size_t i = 0; i < albedo.texels.size(); ++i) {
+        albedo.texels[i] = glm::vec3(pixels[3 * i], pixels[3 * i + 1], pixels[3 * i + 2]) / 255.0f;
+    }
+    stbi_image_free(pixels);
+    return {albedo, {}};
+}
+
+// scene of a bake, shared by all its tasks
+class Baker {
+  public:
+    Baker(const Vertices &mesh, const std::vector<glm::mat4> &models, const std::vector<Light> &lights,
+        const Albedo &albedo, const LightmapSettings &settings);
+
+    // irradiance of every texel of `object`, written to its tile at `origin` in an atlas `width` texels wide; returns
+    // the rays traced
+    size_t bake(size_t object, glm::uvec2 origin, unsigned int width, std::vector<glm::vec3> &irradiance) const;
+
+  private:
+    using Lanes = std::array<glm::vec3, packet_size>;
+
+    const Vertices &m_mesh;
+    const std::vector<Light> &m_lights;
+    const Albedo &m_albedo;
+    LightmapSettings m_settings;
+
+    size_t m_quads;
+    glm::uvec2 m_grid;
+    // world corners of every quad of every object, and the normals of the quads, pointing out of their object
+    std::vector<glm::vec3> m_corners;
+    std::vector<glm::vec3> m_normals;
+    Bvh m_bvh;
+
+    std::vector<float> m_radii;
+    // lights reaching each object, the unculled lists of `ObjectLights` spelled out
+    std::vector<std::vector<uint32_t>> m_object_lights;
+
+    // adds the ambient and direct light of `lights` at the surface points of the `active` lanes to `irradiance`;
+    // returns the shadow rays traced
+    size_t direct(const Lanes &points, const Lanes &normals, std::array<bool, packet_size> active,
+        const std::vector<uint32_t> &lights, Lanes &irradiance) const;
+};
+
+// world corners of every quad of `mesh` drawn with every model
+static std::vector<glm::vec3> world_corners(const Vertices &mesh, const std::vector<glm::mat4> &models) {
+    std::vector<glm::vec3> corners = {};
+    corners.reserve(models.size() * mesh.size());
+    for (const glm::mat4 &model : models) {
+        for (const Vertex &vertex : mesh) {
+            corners.push_back(glm::vec3(model * glm::vec4(vertex.r, 1.0f)));
+        }
+    }
+    return corners;
+}
+
+// the two triangles of every quad, as `quad_indices` splits them
+static std::vector<glm::vec3> triangles(const std::vector<glm::vec3> &corners) {
+    std::vector<glm::vec3> triangles = {};
+    triangles.reserve(corners.size() / 4 * 6);
+    for (size_t quad = 0; quad < corners.size() / 4; ++quad) {
+        for (size_t i : {0, 1, 2, 2, 3, 0}) {
+            triangles.push_back(corners[4 * quad + i]);
+        }
+    }
+    return triangles;
+}
+
+Baker::Baker(const Vertices &mesh, const std::vector<glm::mat4> &models, const std::vector<Light> &lights,
+    const Albedo &albedo, const LightmapSettings &settings)
+    : m_mesh(mesh), m_lights(lights), m_albedo(albedo), m_settings(settings), m_quads(mesh.size() / 4),
+      m_grid(unwrap_grid(mesh)), m_corners(world_corners(mesh, models)), m_bvh(triangles(m_corners)) {
+    glm::vec3 centroid = {};
+    for (const Vertex &vertex : mesh) {
+        centroid += vertex.r / (float) mesh.size();
+    }
+    float radius = 0.0f;
+    for (const Vertex &vertex : mesh) {
+        radius = std::max(radius, glm::distance(centroid, vertex.r));
+    }
+
+    // the vertex normals of transformed meshes may not be normals anymore, the faces give them back
+    std::vector<Sphere> bounds = {};
+    for (size_t object = 0; object < models.size(); ++object) {
+        const glm::mat4 &model = models[object];
+        glm::vec3 center       = glm::vec3(model * glm::vec4(centroid, 1.0f));
+        for (size_t quad = 0; quad < m_quads; ++quad) {
+            const glm::vec3 *corners = &m_corners[4 * (object * m_quads + quad)];
+            glm::vec3 normal         = glm::normalize(glm::cross(corners[1] - corners[0], corners[3] - corners[0]));
+            bool inward              = glm::dot(normal, corners[0] + corners[2] - 2.0f * center) < 0.0f;
+            m_normals.push_back(inward ? -normal : normal);
+        }
+        float scale = std::max({glm::length(glm::vec3(model[0])),
+            glm::length(glm::vec3(model[1])),
+            glm::length(glm::vec3(model[2]))});
+        bounds.push_back({center, scale * radius});
+    }
+
+    for (const Light &light : lights) {
+        m_radii.push_back(light_radius(light));
+    }
+    ObjectLights object_lights = {std::move(bounds)};
+    object_lights.assign(lights, lights.size());
+    std::vector<uint32_t> all(lights.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = i;
+    }
+    for (glm::uvec2 range : object_lights.ranges()) {
+        auto first = object_lights.indices().begin() + range.x;
+        m_object_lights.push_back(
+            range.y == ObjectLights::unculled ? all : std::vector<uint32_t>(first, first + range.y));
+    }
+}
+
+size_t Baker::bake(size_t object, glm::uvec2 origin, unsigned int width, std::vector<glm::vec3> &irradiance) const {
+    const unsigned int texels = m_settings.texels;
+    Random random             = Random(object);
+    size_t rays               = 0;
+
+    for (size_t quad = 0; quad < m_quads; ++quad) {
+        const size_t face        = object * m_quads + quad;
+        const glm::vec3 *corners = &m_corners[4 * face];
+        glm::uvec2 cell          = {quad % m_grid.x, quad / m_grid.x};
+
+        // packets of neighbouring texels, the last one padded with inactive lanes
+        for (unsigned int first = 0; first < texels * texels; first += packet_size) {
+            Lanes points = {}, normals = {}, direct_light = {}, indirect_light = {};
+            std::array<bool, packet_size> active = {};
+            for (size_t lane = 0; lane < packet_size; ++lane) {
+                unsigned int texel = first + lane;
+                active[lane]       = texel < texels * texels;
+                // `unwrap` puts the quad corners on the centers of the corner texels of the cell
+                float s = texels > 1 ? (float) (texel % texels) / (texels - 1) : 0.5f;
+                float t = texels > 1 ? (float) (texel / texels) / (texels - 1) : 0.5f;
+                points[lane]  = (1.0f - s) * (1.0f - t) * corners[0] + s * (1.0f - t) * corners[1] +
+                               s * t * corners[2] + (1.0f - s) * t * corners[3];
+                normals[lane] = m_normals[face];
+            }
+            rays += direct(points, normals, active, m_object_lights[object], direct_light);
+
+            // every path adds the light reflected toward it at each bounce, weighted by the albedos it bounced off;
+            // cosine distributed directions leave the mean of the radiance gathered
+            for (unsigned int sample = 0; sample < m_settings.samples; ++sample) {
+                Lanes position = points, normal = normals, throughput = {};
+                throughput.fill(glm::vec3(1.0f));
+                std::array<bool, packet_size> alive = active;
+                for (unsigned int bounce = 0; bounce < m_settings.bounces; ++bounce) {
+                    RayPacket packet = {};
+                    for (size_t lane = 0; lane < packet_size; ++lane) {
+                        if (alive[lane]) {
+                            glm::vec3 direction = cosine_direction(normal[lane], random);
+                            packet.set(lane, position[lane] + offset * normal[lane], direction, INFINITY);
+                            rays += 1;
+                        } else {
+                            packet.deactivate(lane);
+                        }
+                    }
+                    m_bvh.intersect(packet);
+
+                    std::array<size_t, packet_size> hit_objects = {};
+                    for (size_t lane = 0; lane < packet_size; ++lane) {
+                        alive[lane] = alive[lane] && packet.triangle[lane] >= 0;
+                        if (! alive[lane]) {
+                            continue;
+                        }
+                        // two triangles per quad, corners (0, 1, 2) and (2, 3, 0)
+                        size_t hit_face     = packet.triangle[lane] / 2;
+                        bool second         = packet.triangle[lane] % 2 == 1;
+                        const Vertex *quad  = &m_mesh[4 * (hit_face % m_quads)];
+                        float u             = packet.u[lane], v = packet.v[lane];
+                        glm::vec2 tex       = (1.0f - u - v) * quad[second ? 2 : 0].t + u * quad[second ? 3 : 1].t +
+                                        v * quad[second ? 0 : 2].t;
+                        glm::vec3 direction = packet.direction(lane);
+                        glm::vec3 facing    = m_normals[hit_face];
+
+                        hit_objects[lane] = hit_face / m_quads;
+                        position[lane]    = packet.origin(lane) + packet.t[lane] * direction;
+                        normal[lane]      = glm::dot(facing, direction) > 0.0f ? -facing : facing;
+                        throughput[lane] *= m_albedo(tex);
+                    }
+
+                    // lanes may hit different objects, each lit by its own lights
+                    std::array<bool, packet_size> done = {};
+                    for (size_t lane = 0; lane < packet_size; ++lane) {
+                        if (! alive[lane] || done[lane]) {
+                            continue;
+                        }
+                        std::array<bool, packet_size> group = {};
+                        for (size_t other = lane; other < packet_size; ++other) {
+                            group[other] = alive[other] && hit_objects[other] == hit_objects[lane];
+                            done[other]  = done[other] || group[other];
+                        }
+                        Lanes reflected = {};
+                        rays += direct(position, normal, group, m_object_lights[hit_objects[lane]], reflected);
+                        for (size_t other = lane; other < packet_size; ++other) {
+                            if (group[other]) {
+                                indirect_light[other] += throughput[other] * reflected[other];
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (size_t lane = 0; lane < packet_size; ++lane) {
+                if (! active[lane]) {
+                    continue;
+                }
+                unsigned int texel = first + lane;
+                glm::uvec2 atlas   = origin + cell * texels + glm::uvec2(texel % texels, texel / texels);
+                irradiance[atlas.y * width + atlas.x] =
+                    direct_light[lane] + indirect_light[lane] / (float) std::max(m_settings.samples, 1u);
+            }
+        }
+    }
+    return rays;
+}
+
+size_t Baker::direct(const Lanes &points, const Lanes &normals, std::array<bool, packet_size> active,
+    const std::vector<uint32_t> &lights, Lanes &irradiance) const {
+    size_t rays = 0;
+    for (uint32_t i : lights) {
+        const Light &light = m_lights[i];
+
+        // phong's diffuse term, tested for shadows by one packet of rays toward the light
+        RayPacket packet = {};
+        Lanes lit        = {};
+        bool any         = false;
+        for (size_t lane = 0; lane < packet_size; ++lane) {
+            packet.deactivate(lane);
+            if (! active[lane]) {
+                continue;
+            }
+
+            glm::vec3 direction = glm::normalize(-glm::vec3(light.position));
+            float distance      = INFINITY;
+            float attenuation   = 1.0f;
+            if (light.position.w != 0.0f) {
+                direction = glm::vec3(light.position) - points[lane];
+                distance  = glm::length(direction);
+                if (distance > m_radii[i]) {
+                    continue;
+                }
+                direction /= distance;
+                attenuation = light_attenuation(light, distance, m_radii[i]);
+            }
+            irradiance[lane] += attenuation * light.ambient;
+
+            float cosine = glm::dot(normals[lane], direction);
+            if (cosine <= 0.0f) {
+                continue;
+            }
+            lit[lane] = attenuation * cosine * light.diffuse;
+            packet.set(lane, points[lane] + offset * normals[lane], direction, distance - offset);
+            any = true;
+            rays += 1;
+        }
+        if (! any) {
+            continue;
+        }
+
+        m_bvh.occluded(packet);
+        for (size_t lane = 0; lane < packet_size; ++lane) {
+            if (packet.triangle[lane] < 0) {
+                irradiance[lane] += lit[lane];
+            }
+        }
+    }
+    return rays;
+}
+
+std::pair<Lightmap, Error> Lightmap::bake(const Vertices &mesh, const std::vector<glm::mat4> &models,
+    const std::vector<Light> &lights, const Albedo &albedo, LightmapSettings settings, unsigned int threads) {
+    if (mesh.empty() || mesh.size() % 4 != 0) {
+        return {{}, wrap("lightmaps are baked over meshes made of quads")};
+    }
+    settings.texels = std::max(settings.texels, 1u);
+
+    Lightmap lightmap   = {};
+    lightmap.m_key      = key(models, lights);
+    lightmap.m_texels   = settings.texels;
+    lightmap.m_tile     = unwrap_grid(mesh) * settings.texels;
+    lightmap.m_objects  = models.size();
+    lightmap.m_settings = settings;
+
+    // tiles laid out in rows, the atlas as close to a square as they get
+    glm::uvec2 tile = lightmap.m_tile;
+    if (tile.x > max_size || tile.y > max_size) {
+        return {{},
+            wrap("lightmap tiles of " + std::to_string(tile.x) + "x" + std::to_string(tile.y) +
+                 " texels do not fit a texture")};
+    }
+    float side         = std::ceil(std::sqrt((float) models.size() * tile.y / tile.x));
+    lightmap.m_columns = std::clamp((unsigned int) side, 1u, max_size / tile.x);
+    unsigned int rows  = (lightmap.m_objects + lightmap.m_columns - 1) / lightmap.m_columns;
+    if ((size_t) rows * tile.y > max_size) {
+        return {{},
+            wrap(std::to_string(models.size()) + " objects do not fit a lightmap of " +
+                 std::to_string(settings.texels) + " texels a quad")};
+    }
+    lightmap.m_width  = lightmap.m_columns * tile.x;
+    lightmap.m_height = std::max(rows, 1u) * tile.y;
+    lightmap.m_irradiance.assign((size_t) lightmap.m_width * lightmap.m_height, glm::vec3(0.0f));
+
+    Baker baker = {mesh, models, lights, albedo, settings};
+    std::vector<size_t> rays(models.size());
+    WorkerPool pool(threads);
+    pool.run(models.size(), [&](size_t object) {
+        glm::uvec2 origin = glm::uvec2(object % lightmap.m_columns, object / lightmap.m_columns) * tile;
+        rays[object]      = baker.bake(object, origin, lightmap.m_width, lightmap.m_irradiance);
+    });
+    for (size_t count : rays) {
+        lightmap.m_rays += count;
+    }
+    return {std::move(lightmap), {}};
+}
+
+std::pair<Lightmap, Error> Lightmap::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    LightmapHeader header = {};
+    if (! file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        return {{}, wrap("cannot read lightmap " + path)};
+    }
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+        return {{}, wrap(path + " is not a lightmap of version " + std::to_string(version))};
+    }
+    // the atlas fits a texture and its tiles, laid out in rows of `columns`, fit the atlas
+    size_t rows = header.columns > 0 ? ((size_t) header.objects + header.columns - 1) / header.columns : 0;
+    if (header.width == 0 || header.width > max_size || header.height == 0 || header.height > max_size ||
+        header.tile_width == 0 || header.tile_height == 0 || header.tile_height > header.height ||
+        header.columns == 0 || (size_t) header.tile_width * header.columns > header.width ||
+        rows * header.tile_height > header.height) {
+        return {{}, wrap(path + " has a corrupt lightmap header")};
+    }
+
+    Lightmap lightmap   = {};
+    lightmap.m_key      = header.key;
+    lightmap.m_width    = header.width;
+    lightmap.m_height   = header.height;
+    lightmap.m_texels   = header.texels;
+    lightmap.m_tile     = {header.tile_width, header.tile_height};
+    lightmap.m_columns  = header.columns;
+    lightmap.m_objects  = header.objects;
+    lightmap.m_settings = {header.texels, header.samples, header.bounces};
+    lightmap.m_irradiance.resize((size_t) header.width * header.height);
+    if (! file.read(reinterpret_cast<char *>(lightmap.m_irradiance.data()),
+            lightmap.m_irradiance.size() * sizeof(glm::vec3))) {
+        return {{}, wrap("truncated lightmap " + path)};
+    }
+    return {std::move(lightmap), {}};
+}
+
+Error Lightmap::save(const std::string &path) const {
+    LightmapHeader header = {
+        .magic       = {magic[0], magic[1], magic[2], magic[3]},
+        .version     = version,
+        .key         = m_key,
+        .width       = m_width,
+        .height      = m_height,
+        .texels      = m_texels,
+        .tile_width  = m_tile.x,
+        .tile_height = m_tile.y,
+        .columns     = m_columns,
+        .objects     = m_objects,
+        .samples     = m_settings.samples,
+        .bounces     = m_settings.bounces,
+        .padding     = 0,
+    };
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(m_irradiance.data()), m_irradiance.size() * sizeof(glm::vec3));
+    if (! file) {
+        return wrap("cannot write lightmap " + path);
+    }
+    return {};
+}
+
+uint64_t Lightmap::key(const std::vector<glm::mat4> &models, const std::vector<Light> &lights) {
+    // FNV-1a over everything the bake reads of the scene
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix      = [&hash](const void *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<const unsigned char *>(data)[i]) * 0x100000001b3ull;
+        }
+    };
+    for (const glm::mat4 &model : models) {
+        mix(&model, sizeof(model));
+    }
+    for (const Light &light : lights) {
+        mix(&light.position, sizeof(light.position));
+        mix(&light.ambient, sizeof(light.ambient));
+        mix(&light.diffuse, sizeof(light.diffuse));
+        mix(&light.constant, sizeof(light.constant));
+        mix(&light.linear, sizeof(light.linear));
+        mix(&light.quadratic, sizeof(light.quadratic));
+    }
+    return hash;
+}
+
+LightmapTexture::LightmapTexture(const Lightmap &lightmap)
+    : m_layout({(int) lightmap.columns(), (int) lightmap.tile().x, (int) lightmap.tile().y}) {
+    glGenTextures(1, &m_ID);
+    StateCache::bind_texture(GL_TEXTURE0 + lightmap_unit, GL_TEXTURE_2D, m_ID);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB16F, lightmap.width(), lightmap.height());
+    glTexSubImage2D(GL_TEXTURE_2D,
+        0,
+        0,
+        0,
+        lightmap.width(),
+        lightmap.height(),
+        GL_RGB,
+        GL_FLOAT,
+        lightmap.irradiance().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+LightmapTexture::~LightmapTexture() {
+    StateCache::forget_texture(m_ID);
+    glDeleteTextures(1, &m_ID);
+}
+
+void LightmapTexture::bind() const { StateCache::bind_texture(GL_TEXTURE0 + lightmap_unit, GL_TEXTURE_2D, m_ID); }
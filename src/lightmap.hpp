@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "error.hpp"
+#include "light.hpp"
+#include "vertex.hpp"
+
+// texture unit of the lightmap, mirrored by the sampler binding of res/lightmap.glsl
+constexpr static unsigned int lightmap_unit = 8;
+
+struct LightmapSettings {
+    // texels along each side of a quad, see `unwrap`
+    unsigned int texels = 8;
+    // paths traced from every texel for the indirect light, and the surfaces each bounces off
+    unsigned int samples = 64;
+    unsigned int bounces = 2;
+};
+
+// diffuse color of the static geometry on the CPU, an RGB image looked up with repeat wrapping and no filtering
+struct Albedo {
+    int width                     = 1;
+    int height                    = 1;
+    std::vector<glm::vec3> texels = {glm::vec3(1.0f)};
+
+    glm::vec3 operator()(glm::vec2 tex) const;
+
+    // laid out as `Texture::from_file` uploads it, first row at t = 0
+    static std::pair<Albedo, Error> from_file(const std::string &path);
+};
+
+// Diffuse lighting of static geometry, path traced on the CPU ahead of time. Every object gets a tile of the atlas,
+// laid out by `unwrap`, and every texel the irradiance of the static lights over its surface: their ambient terms,
+// their direct light with the shadows of every object, and the light bouncing off the objects up to `bounces` times,
+// gathered from cosine distributed paths ending each bounce on a shadow ray to every light. Shaders multiply it by the
+// surface color and only evaluate the dynamic lights on top, the specular highlights of the static lights are lost.
+//
+// Rays are traced through a `Bvh` over every triangle of the scene in packets of four neighbouring texels, and objects
+// are shared out to a pool of threads, each drawing its random numbers from a sequence of its own: a bake only depends
+// on its scene and settings.
+class Lightmap {
+  public:
+    Lightmap() = default;
+
+    // `mesh`, unwrapped with `settings.texels`, drawn once per model; `lights` are the static lights of the scene, spot
+    // cones aside
+    static std::pair<Lightmap, Error> bake(const Vertices &mesh, const std::vector<glm::mat4> &models,
+        const std::vector<Light> &lights, const Albedo &albedo, LightmapSettings settings = {},
+        unsigned int threads = std::thread::hardware_concurrency());
+
+    static std::pair<Lightmap, Error> load(const std::string &path);
+    Error save(const std::string &path) const;
+
+    // identifies the scene a lightmap was baked for, from its objects and lights
+    static uint64_t key(const std::vector<glm::mat4> &models, const std::vector<Light> &lights);
+    uint64_t key() const { return m_key; }
+
+    unsigned int width() const { return m_width; }
+    unsigned int height() const { return m_height; }
+    // texels a side of each quad, and of each object's tile
+    unsigned int texels() const { return m_texels; }
+    glm::uvec2 tile() const { return m_tile; }
+    // tiles per row, object i at (i % columns, i / columns)
+    unsigned int columns() const { return m_columns; }
+    unsigned int objects() const { return m_objects; }
+    const LightmapSettings &settings() const { return m_settings; }
+
+    // of every texel, row by row from the bottom of the atlas
+    const std::vector<glm::vec3> &irradiance() const { return m_irradiance; }
+    // rays traced by `bake`, shadow rays comprised; 0 once loaded
+    size_t rays() const { return m_rays; }
+
+  private:
+    uint64_t m_key              = 0;
+    unsigned int m_width        = 0;
+    unsigned int m_height       = 0;
+    unsigned int m_texels       = 0;
+    glm::uvec2 m_tile           = {};
+    unsigned int m_columns      = 0;
+    unsigned int m_objects      = 0;
+    LightmapSettings m_settings = {};
+
+    std::vector<glm::vec3> m_irradiance;
+    size_t m_rays = 0;
+};
+
+// mirror of `u_lightmap` in res/lightmap.glsl, `enabled` aside
+struct LightmapLayout {
+    int columns;
+    int tile_width;
+    int tile_height;
+};
+
+// `Lightmap` uploaded as a half float texture, filtered bilinearly
+class LightmapTexture {
+  public:
+    explicit LightmapTexture(const Lightmap &lightmap);
+    ~LightmapTexture();
+
+    // on `lightmap_unit`
+    void bind() const;
+    const LightmapLayout &layout() const { return m_layout; }
+
+    LightmapTexture(const LightmapTexture &other)            = delete;
+    LightmapTexture &operator=(const LightmapTexture &other) = delete;
+
+  private:
+    unsigned int m_ID;
+    LightmapLayout m_layout;
+};
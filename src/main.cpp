@@ -1,10 +1,18 @@
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
 #include <optional>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -18,12 +26,34 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "benchmark.hpp"
 #include "camera.hpp"
 #include "control.hpp"
 #include "debug.hpp"
+#include "frame_log.hpp"
+#include "framebuffer.hpp"
+#include "gbuffer.hpp"
+#include "gpu_timer.hpp"
+#include "headless.hpp"
 #include "index_buffer.hpp"
+#include "indirect_buffer.hpp"
+#include "light.hpp"
+#include "light_clusters.hpp"
+#include "light_registry.hpp"
+#include "lightmap.hpp"
+#include "mesh_loader.hpp"
+#include "mesh_pool.hpp"
+#include "object_lights.hpp"
 #include "primitives.hpp"
+#include "program_cache.hpp"
+#include "render_queue.hpp"
+#include "ring_buffer.hpp"
+#include "scene.hpp"
 #include "shader.hpp"
+#include "shader_watcher.hpp"
+#include "shadow_atlas.hpp"
+#include "state_cache.hpp"
+#include "storage_buffer.hpp"
 #include "texture.hpp"
 #include "vertex_array.hpp"
 
@@ -42,92 +72,674 @@ constexpr static float w = 2 * glm::pi<float>();
 std::tuple<float, float, float> rgb(float t) { return {std::cos(w * t), std::cos(w / 2 * t), std::cos(w / 4 * t)}; }
 glm::vec3 orbit(float radius, float t) { return radius * glm::vec3(std::sin(w * t), 0.0f, std::cos(w * t)); }
 
+constexpr static float near = 0.1f;
+// far enough to see the whole scene from the headless camera path
+float far_plane(const Scene &scene) { return std::max(100.0f, 3.0f * scene.radius); }
+
+// camera of the headless path at `t`, one orbit around the scene from 0 to 1
+void headless_camera(Camera &camera, const Scene &scene, float t) {
+    camera.position(scene.center + orbit(1.5f * scene.radius, t) + 0.25f * scene.radius * glm::vec3(0.0f, 1.0f, 0.0f));
+    camera.look_at(scene.center);
+}
+
+Light point_light(glm::vec3 position, glm::vec3 color, glm::vec2 attenuation) {
+    return {
+        .position  = glm::vec4(position, 1.0f),
+        .ambient   = 0.2f * color,
+        .diffuse   = 0.5f * color,
+        .specular  = color,
+        .linear    = attenuation.x,
+        .quadratic = attenuation.y,
+    };
+}
+
 std::string usage(const std::string &name) {
-    return "usage: " + name + "width height\n" + "arguments:\n" +
+    return "usage: " + name +
+           " [--draw-path naive|instanced|indirect] [--shading forward|deferred] [--bench uniforms|clusters|mesh]" +
+           " [--mesh file] [--shadow-budget N] [--bake file [--samples N] [--bounces N] [--texels N]]" +
+           " [--lightmap file] [--headless [--frames N] [--output file]]" +
+           " [--scene tutorial|grid|random [--cubes N] [--lights N] [--seed N]] [--no-program-cache]" +
+           " [width height]\n" + "arguments:\n" +
            "  width     width of window to be created, in pixels\n" +
-           "  height    height of window to be created, in pixels\n";
+           "  height    height of window to be created, in pixels\n" + "options:\n" +
+           "  --draw-path    cube field submission: one draw per cube (naive), a single instanced draw or a\n" +
+           "                 multi draw indirect of every static mesh (indirect)\n" +
+           "  --shading      light the cubes as they are drawn (forward) or from a G-buffer, each light shading\n" +
+           "                 the pixels of its volume (deferred)\n" +
+           "  --shadow-budget  render at most N stale shadow maps per frame (default 4), the others wait for the\n" +
+           "                   next frames\n" +
+           "  --bake         path trace the static lights of the scene into a lightmap on every core, write it to\n" +
+           "                 file and exit without any GPU: N paths per texel (default 64), bouncing N times\n" +
+           "                 (default 2), over N texels a side of each cube face (default 8)\n" +
+           "  --lightmap     shade the cubes with a lightmap baked for the same scene, only evaluating the\n" +
+           "                 flashlight per pixel (L toggles it, forward shading only)\n" +
+           "  --bench        run the named CPU microbenchmark instead of rendering, clusters runs on the generated\n" +
+           "                 scene and mesh loads the --mesh file, both without any GPU\n" +
+           "  --mesh         Wavefront OBJ or glTF (.gltf, .glb) file loaded by --bench mesh\n" +
+           "  --headless     render N frames (default 600) offscreen along a fixed camera path, without any\n" +
+           "                 window, and write per-frame CPU and GPU times to file (default frames.csv, JSON if\n" +
+           "                 it ends with .json)\n" +
+           "  --scene        cube field: learnopengl's one (tutorial), or N cubes (default 1000) laid on a grid or\n" +
+           "                 at random and N lights (default 4) at random, the same for a given seed (default 0)\n" +
+           "  --no-program-cache  always compile and link the programs instead of loading their binaries from\n" +
+           "                      the cache directory next to the executable\n";
+}
+
+struct Options {
+    int width  = 1280;
+    int height = 720;
+
+    DrawPath draw_path = DrawPath::NAIVE;
+    Shading shading    = Shading::FORWARD;
+
+    unsigned int shadow_budget = 4;
+
+    std::string bake     = "";
+    unsigned int samples = LightmapSettings {}.samples;
+    unsigned int bounces = LightmapSettings {}.bounces;
+    unsigned int texels  = LightmapSettings {}.texels;
+    std::string lightmap = "";
+
+    std::string bench = "";
+    std::string mesh  = "";
+
+    bool headless       = false;
+    unsigned int frames = 600;
+    std::string output  = "frames.csv";
+
+    Layout layout       = Layout::TUTORIAL;
+    unsigned int cubes  = 1000;
+    unsigned int lights = 4;
+    unsigned int seed   = 0;
+
+    bool program_cache = true;
+};
+
+static const std::map<std::string, DrawPath> draw_paths = {
+    {"naive", DrawPath::NAIVE},
+    {"instanced", DrawPath::INSTANCED},
+    {"indirect", DrawPath::INDIRECT},
+};
+
+static const std::map<std::string, Shading> shadings = {
+    {"forward", Shading::FORWARD},
+    {"deferred", Shading::DEFERRED},
+};
+
+static const std::map<std::string, Layout> layouts = {
+    {"tutorial", Layout::TUTORIAL},
+    {"grid", Layout::GRID},
+    {"random", Layout::RANDOM},
+};
+
+// reverse lookup in the option maps above
+template <typename T> std::string option_name(const std::map<std::string, T> &options, T value) {
+    auto it =
+        std::find_if(options.begin(), options.end(), [value](const auto &option) { return option.second == value; });
+    return it != options.end() ? it->first : "";
 }
 
-std::pair<std::tuple<int, int>, Error> from_args(int argc, char *argv[]) {
-    if ((argc - 1) == 2) {
+Error parse_count(const std::string &arg, unsigned int &count) {
+    // std::stoul skips spaces, takes a minus sign and wraps it, and stops at the first character that is not a digit
+    if (arg.empty() || ! std::isdigit((unsigned char) arg[0])) {
+        return wrap("expected a count, got " + arg);
+    }
+    size_t end          = 0;
+    unsigned long value = 0;
+    try {
+        value = std::stoul(arg, &end);
+    } catch (const std::logic_error &e) {
+        return wrap(e.what());
+    }
+    if (end != arg.size()) {
+        return wrap("expected a count, got " + arg);
+    }
+    if (value > std::numeric_limits<unsigned int>::max()) {
+        return wrap("count " + arg + " is out of range");
+    }
+    count = value;
+    return {};
+}
+
+std::pair<Options, Error> from_args(int argc, char *argv[]) {
+    const std::map<std::string, unsigned int Options::*> counts = {
+        {"--frames", &Options::frames},
+        {"--cubes", &Options::cubes},
+        {"--lights", &Options::lights},
+        {"--seed", &Options::seed},
+        {"--shadow-budget", &Options::shadow_budget},
+        {"--samples", &Options::samples},
+        {"--bounces", &Options::bounces},
+        {"--texels", &Options::texels},
+    };
+
+    Options options                     = {};
+    std::vector<std::string> positional = {};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--draw-path" && i + 1 < argc) {
+            if (! draw_paths.contains(argv[i + 1])) {
+                return {{}, wrap("unknown draw path '" + std::string(argv[i + 1]) + "'\n" + usage(argv[0]))};
+            }
+            options.draw_path = draw_paths.at(argv[++i]);
+        } else if (arg == "--shading" && i + 1 < argc) {
+            if (! shadings.contains(argv[i + 1])) {
+                return {{}, wrap("unknown shading '" + std::string(argv[i + 1]) + "'\n" + usage(argv[0]))};
+            }
+            options.shading = shadings.at(argv[++i]);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            if (! std::set<std::string> {"uniforms", "clusters", "mesh"}.contains(argv[i + 1])) {
+                return {{}, wrap("unknown benchmark '" + std::string(argv[i + 1]) + "'\n" + usage(argv[0]))};
+            }
+            options.bench = argv[++i];
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--no-program-cache") {
+            options.program_cache = false;
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--mesh" && i + 1 < argc) {
+            options.mesh = argv[++i];
+        } else if (arg == "--bake" && i + 1 < argc) {
+            options.bake = argv[++i];
+        } else if (arg == "--lightmap" && i + 1 < argc) {
+            options.lightmap = argv[++i];
+        } else if (arg == "--scene" && i + 1 < argc) {
+            if (! layouts.contains(argv[i + 1])) {
+                return {{}, wrap("unknown scene '" + std::string(argv[i + 1]) + "'\n" + usage(argv[0]))};
+            }
+            options.layout = layouts.at(argv[++i]);
+        } else if (counts.contains(arg) && i + 1 < argc) {
+            if (Error error = parse_count(argv[++i], options.*counts.at(arg)); error.has_value()) {
+                return {{}, wrap(error)};
+            }
+        } else if (arg.starts_with("--")) {
+            return {{}, wrap("unknown option '" + arg + "'\n" + usage(argv[0]))};
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() == 2) {
         try {
-            return {{std::stoi(argv[1]), std::stoi(argv[2])}, {}};
+            options.width  = std::stoi(positional[0]);
+            options.height = std::stoi(positional[1]);
         } catch (const std::invalid_argument &e) {
             return {{}, wrap(e.what())};
         }
     }
-    return {{1280, 720}, {}};
+    return {options, {}};
 }
 
-enum Primitive { LINES = GL_LINES, TRIANGLES = GL_TRIANGLES };
-Error draw(Primitive primitive, const VertexArray &va, const IndexBuffer &ib, Shader &shader,
-    const std::vector<Uniform> &uniforms,
-    const std::optional<std::vector<std::pair<std::string, Texture>>> &textures = {},
-    const std::vector<Light> &lights                                            = {}) {
-    va.bind();
-    ib.bind();
-    shader.bind();
+struct CubeUniforms {
+    UniformHandle<glm::mat4> model;
+    UniformHandle<glm::mat4> ti_model;
+
+    UniformHandle<float> material_shininess;
+    UniformHandle<int> material_diffuse;
+    UniformHandle<int> material_specular;
+
+    // programs lighting the cubes themselves, the G-buffer ones leave these unresolved
+    UniformHandle<bool> lightmap_enabled;
+    UniformHandle<int> lightmap_columns;
+    UniformHandle<int> lightmap_tile_width;
+    UniformHandle<int> lightmap_tile_height;
+
+    // `per_object` programs take their model matrices as uniforms, instanced ones as vertex attributes
+    static std::pair<CubeUniforms, Error> from_shader(Shader &shader, bool per_object) {
+        CubeUniforms uniforms = {};
+        const bool lit        = std::any_of(shader.blocks().begin(), shader.blocks().end(), [](const BlockInfo &block) {
+            return block.name == "Lights";
+        });
+        for (Error error : {
+                 per_object ? shader.resolve("u_model", uniforms.model) : Error {},
+                 per_object ? shader.resolve("u_ti_model", uniforms.ti_model) : Error {},
+                 shader.resolve("u_material.shininess", uniforms.material_shininess),
+                 shader.resolve("u_material.diffuse", uniforms.material_diffuse),
+                 shader.resolve("u_material.specular", uniforms.material_specular),
+                 lit ? shader.resolve("u_lightmap.enabled", uniforms.lightmap_enabled) : Error {},
+                 lit ? shader.resolve("u_lightmap.columns", uniforms.lightmap_columns) : Error {},
+                 lit ? shader.resolve("u_lightmap.tile_width", uniforms.lightmap_tile_width) : Error {},
+                 lit ? shader.resolve("u_lightmap.tile_height", uniforms.lightmap_tile_height) : Error {},
+                 // the blocks must match their C++ mirrors, layouts are not checked past their size
+                 shader.check_block("Camera", camera_binding, sizeof(CameraStd140)),
+                 // runtime sized arrays count for a single element
+                 shader.check_block("Lights", lights_binding, std430_size(1)),
+                 shader.check_block("Clusters", clusters_binding, sizeof(ClustersStd430) + sizeof(glm::uvec2)),
+                 shader.check_block("ClusterLights", cluster_lights_binding, sizeof(uint32_t)),
+                 shader.check_block("ObjectLightRanges", object_light_ranges_binding, sizeof(glm::uvec2)),
+                 shader.check_block("ObjectLights", object_lights_binding, sizeof(uint32_t)),
+                 shader.check_block("Objects", objects_binding, sizeof(ObjectStd430)),
+                 shader.check_block("Shadows", shadows_binding, sizeof(ShadowStd430)),
+             }) {
+            if (error.has_value()) {
+                return {{}, wrap(error)};
+            }
+        }
+        return {uniforms, {}};
+    }
+};
+
+// light proxies and axis lines
+struct ProxyUniforms {
+    UniformHandle<glm::mat4> model;
+    UniformHandle<glm::vec3> light_color;
 
-    if (textures.has_value()) {
-        std::vector<Uniform> samplers = {};
-        for (const auto &[name, texture] : textures.value()) {
-            texture.bind();
-            samplers.push_back({name, texture.slot()});
+    static std::pair<ProxyUniforms, Error> from_shader(Shader &shader, bool colored) {
+        ProxyUniforms uniforms = {};
+        for (Error error : {
+                 shader.resolve("u_model", uniforms.model),
+                 shader.check_block("Camera", camera_binding, sizeof(CameraStd140)),
+                 colored ? shader.resolve("u_light_color", uniforms.light_color) : Error {},
+             }) {
+            if (error.has_value()) {
+                return {{}, wrap(error)};
+            }
         }
+        return {uniforms, {}};
+    }
+};
 
-        if (Error error = shader.set_uniforms(samplers); error.has_value()) {
-            return error;
+// lighting passes of deferred shading, which read the G-buffer through samplers bound in the shader
+struct DeferredUniforms {
+    UniformHandle<glm::vec3> background;
+
+    // `volume` programs shade the volume of one light each, the others the whole screen
+    static std::pair<DeferredUniforms, Error> from_shader(Shader &shader, bool volume) {
+        DeferredUniforms uniforms = {};
+        for (Error error : {
+                 volume ? Error {} : shader.resolve("u_background", uniforms.background),
+                 shader.check_block("Camera", camera_binding, sizeof(CameraStd140)),
+                 shader.check_block("Lights", lights_binding, std430_size(1)),
+                 shader.check_block("Shadows", shadows_binding, sizeof(ShadowStd430)),
+             }) {
+            if (error.has_value()) {
+                return {{}, wrap(error)};
+            }
         }
+        return {uniforms, {}};
     }
+};
+
+// shadow casters, drawn into the map of a single light
+struct ShadowUniforms {
+    UniformHandle<glm::mat4> view_projection;
+    std::array<UniformHandle<glm::mat4>, 6> faces;
+    UniformHandle<int> cube;
+    UniformHandle<glm::vec3> light_position;
+    UniformHandle<float> far;
 
-    if (Error error = shader.set_uniforms(uniforms); error.has_value()) {
-        return error;
+    // `cube` programs render the six faces of a cube map at once, the others a spot map
+    static std::pair<ShadowUniforms, Error> from_shader(Shader &shader, bool cube) {
+        ShadowUniforms uniforms = {};
+        for (size_t face = 0; cube && face < uniforms.faces.size(); ++face) {
+            if (Error error = shader.resolve("u_faces[" + std::to_string(face) + "]", uniforms.faces[face]);
+                error.has_value()) {
+                return {{}, wrap(error)};
+            }
+        }
+        for (Error error : {
+                 cube ? Error {} : shader.resolve("u_view_projection", uniforms.view_projection),
+                 cube ? shader.resolve("u_cube", uniforms.cube) : Error {},
+                 shader.resolve("u_light_position", uniforms.light_position),
+                 shader.resolve("u_far", uniforms.far),
+                 shader.check_block("Objects", objects_binding, sizeof(ObjectStd430)),
+             }) {
+            if (error.has_value()) {
+                return {{}, wrap(error)};
+            }
+        }
+        return {uniforms, {}};
     }
+};
+
+void report(const RenderQueue::Stats &total, unsigned int frames) {
+    auto per_frame = [frames](unsigned int count) { return (float) count / (float) std::max(frames, 1u); };
+    std::cout << "render queue, average per frame over " << frames << " frames\n"
+              << "  draws              " << per_frame(total.draws) << "\n"
+              << "  program switches   " << per_frame(total.unsorted_program_switches) << " -> "
+              << per_frame(total.program_switches) << "\n"
+              << "  material switches  " << per_frame(total.unsorted_material_switches) << " -> "
+              << per_frame(total.material_switches) << "\n"
+              << "  mesh switches      " << per_frame(total.unsorted_mesh_switches) << " -> "
+              << per_frame(total.mesh_switches) << "\n"
+              << "  saved              " << per_frame(total.saved()) << "\n";
+}
+
+void report(const StateCache::Stats &total, unsigned int frames) {
+    auto per_frame = [frames](const StateCache::Counter &counter) {
+        std::ostringstream oss;
+        oss << (float) counter.issued / (float) std::max(frames, 1u) << " issued, "
+            << (float) counter.skipped / (float) std::max(frames, 1u) << " skipped";
+        return oss.str();
+    };
+    std::cout << "state cache, average per frame over " << frames << " frames\n"
+              << "  glUseProgram       " << per_frame(total.program) << "\n"
+              << "  glBindVertexArray  " << per_frame(total.vertex_array) << "\n"
+              << "  glBindBuffer       " << per_frame(total.buffer) << "\n"
+              << "  glActiveTexture    " << per_frame(total.active_texture) << "\n"
+              << "  glBindTexture      " << per_frame(total.texture) << "\n"
+              << "  glUniform*         " << per_frame(total.uniform) << "\n";
+}
+
+void report(const RingBuffer::Stats &total, unsigned int frames) {
+    std::cout << "ring buffer, fence waits over " << frames << " frames\n"
+              << "  waits              " << total.waits << "\n"
+              << "  average wait       " << (total.waits > 0 ? total.wait_ms / total.waits : 0.0) << " ms\n"
+              << "  max wait           " << total.max_wait_ms << " ms\n";
+}
+
+void report(const LightRegistry::Stats &total, unsigned int frames) {
+    auto per_frame = [frames](size_t count) { return (float) count / (float) std::max(frames, 1u); };
+    std::cout << "light registry, uploads per frame over " << frames << " frames\n"
+              << "  writes             " << per_frame(total.writes) << "\n"
+              << "  bytes              " << per_frame(total.bytes) << "\n";
+}
+
+void report(const ShadowAtlas::Stats &total, unsigned int frames) {
+    auto per_frame = [frames](unsigned int count) { return (float) count / (float) std::max(frames, 1u); };
+    std::cout << "shadow maps, average per frame over " << frames << " frames\n"
+              << "  renders            " << per_frame(total.renders) << "\n"
+              << "  left stale         " << per_frame(total.stale) << "\n";
+}
 
-    if (Error error = shader.set_lights("u_lights", lights); error.has_value()) {
-        return error;
+void report(const GpuTimer &timer) {
+    std::cout << "gpu time per pass over the last " << GpuTimer::window << " frames at most, " << timer.dropped()
+              << " pending results dropped\n";
+    for (size_t i = 0; i < static_cast<size_t>(Pass::COUNT); ++i) {
+        Pass pass               = static_cast<Pass>(i);
+        GpuTimer::Summary stats = timer.summary(pass);
+        std::cout << "  " << std::left << std::setw(19) << pass_name(pass) << std::right << "min " << stats.min_ms
+                  << " ms, avg " << stats.avg_ms << " ms, p99 " << stats.p99_ms << " ms\n";
     }
+}
+
+// program rebuilt when one of its sources is written; `adopt` resolves the uniforms of the new program and, when it
+// fails, leaves everything untouched so that the previous program stays in use
+struct Reloadable {
+    Shader *shader;
+    std::filesystem::path vertex;
+    std::filesystem::path fragment;
+    Defines defines;
+    std::function<Error(Shader &)> adopt;
+    // empty for programs without a geometry stage
+    std::filesystem::path geometry = {};
+};
+
+template <typename Uniforms> std::function<Error(Shader &)> adopt(Uniforms &uniforms, bool flag) {
+    return [&uniforms, flag](Shader &program) -> Error {
+        auto [resolved, error] = Uniforms::from_shader(program, flag);
+        if (error.has_value()) {
+            return wrap(error);
+        }
+        uniforms = resolved;
+        return {};
+    };
+}
+
+void reload(const std::vector<Reloadable> &reloadables, const std::vector<std::string> &changes) {
+    if (changes.empty()) {
+        return;
+    }
+
+    // includes comprised
+    auto changed = [&changes](const Shader &shader) {
+        return std::any_of(shader.sources().begin(), shader.sources().end(), [&changes](const auto &path) {
+            return std::find(changes.begin(), changes.end(), path.filename().string()) != changes.end();
+        });
+    };
+
+    for (const Reloadable &reloadable : reloadables) {
+        if (! changed(*reloadable.shader)) {
+            continue;
+        }
+
+        auto [program, error] =
+            reloadable.geometry.empty()
+                ? Shader::from_files(reloadable.vertex, reloadable.fragment, reloadable.defines)
+                : Shader::from_files(reloadable.vertex, reloadable.geometry, reloadable.fragment, reloadable.defines);
+        if (! error.has_value()) {
+            error = reloadable.adopt(program);
+        }
+        std::string name = reloadable.vertex.filename().string() + " + " +
+                           (reloadable.geometry.empty() ? "" : reloadable.geometry.filename().string() + " + ") +
+                           reloadable.fragment.filename().string();
+        if (error.has_value()) {
+            std::cerr << "reloading " << name << " failed, keeping the previous program\n" << error.value() << "\n";
+            continue;
+        }
+        *reloadable.shader = std::move(program);
+        std::cout << "reloaded " << name << "\n";
+    }
+}
+
+glm::mat4 cube_model(size_t i, const glm::vec3 &position) {
+    return glm::rotate(glm::translate(glm::mat4(1.0f), position), i * pi / 8.0f, glm::vec3(1.0f, 0.3f, 0.5f));
+}
 
-    glDrawElements(primitive, ib.count(), GL_UNSIGNED_INT, nullptr);
+std::vector<glm::mat4> cube_models(const Scene &scene) {
+    std::vector<glm::mat4> models = {};
+    for (size_t i = 0; i < scene.cube_positions.size(); ++i) {
+        models.push_back(cube_model(i, scene.cube_positions[i]));
+    }
+    return models;
+}
+
+std::vector<Light> point_lights(const Scene &scene) {
+    std::vector<Light> lights = {};
+    for (auto [position, color] : scene.lights) {
+        lights.push_back(point_light(position, color, scene.attenuation));
+    }
+    return lights;
+}
+
+// the mesh of every cube, its faces unwrapped for lightmaps of `texels` texels a side
+Vertices cube_mesh(unsigned int texels) {
+    return unwrap(cube({0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, 1.0f), texels);
+}
+
+// clustered light assignment of the generated scene from the start of the headless camera path, checked against a
+// brute force one; runs without any GL context
+Error bench_clusters(const Options &options) {
+    const Scene scene               = generate_scene(options.layout, options.cubes, options.lights, options.seed);
+    const std::vector<Light> lights = point_lights(scene);
+
+    Camera eye = camera;
+    headless_camera(eye, scene, 0.0f);
+    const Frustum frustum = {
+        eye.view(), eye.fov(), (float) options.width / (float) options.height, near, far_plane(scene)};
+
+    constexpr size_t iterations = 200;
+    LightClusters single        = {{}, 1};
+    LightClusters pooled        = {};
+    double single_ns            = measure(iterations, [&]() { single.assign(lights, lights.size(), frustum); });
+    double pooled_ns            = measure(iterations, [&]() { pooled.assign(lights, lights.size(), frustum); });
+
+    const ClusterDimensions &dimensions = pooled.dimensions();
+    size_t mismatches = 0, full = 0, cluster = 0;
+    for (unsigned int z = 0; z < dimensions.z; ++z) {
+        for (unsigned int y = 0; y < dimensions.y; ++y) {
+            for (unsigned int x = 0; x < dimensions.x; ++x, ++cluster) {
+                auto [min, max]                = pooled.bounds(x, y, z, frustum);
+                std::vector<uint32_t> expected = {};
+                for (size_t i = 0; i < lights.size(); ++i) {
+                    glm::vec3 center = glm::vec3(frustum.view * lights[i].position);
+                    glm::vec3 delta  = glm::max(glm::max(min - center, center - max), glm::vec3(0.0f));
+                    float radius     = light_radius(lights[i]);
+                    if (glm::dot(delta, delta) <= radius * radius) {
+                        expected.push_back(i);
+                    }
+                }
+                // the first lights of a full cluster win
+                expected.resize(std::min(expected.size(), max_cluster_lights));
+                glm::uvec2 range = pooled.ranges()[cluster];
+                full += range.y == max_cluster_lights;
+                if (! std::equal(expected.begin(),
+                        expected.end(),
+                        pooled.indices().begin() + range.x,
+                        pooled.indices().begin() + range.x + range.y)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    std::cout << "clustered light assignment of " << lights.size() << " lights to " << dimensions.x << "x"
+              << dimensions.y << "x" << dimensions.z << " clusters, " << iterations << " iterations\n";
+    report("1 thread", single_ns, "assignment");
+    report(std::to_string(pooled.threads()) + " threads (pool)", pooled_ns, "assignment");
+    std::cout << "  lights per cluster " << (float) pooled.indices().size() / (float) pooled.size() << "\n"
+              << "  full clusters      " << full << "\n"
+              << "  mismatches         " << mismatches << "\n";
+    if (mismatches > 0) {
+        return wrap("clusters differ from the brute force assignment");
+    }
     return {};
 }
 
-Error run(int argc, char *argv[]) {
-    auto [args, error] = from_args(argc, argv);
+// `options.mesh` loaded on one thread and on the pool, checked to be the same mesh; runs without any GL context
+Error bench_mesh(const Options &options) {
+    if (options.mesh.empty()) {
+        return wrap("--bench mesh needs a --mesh file");
+    }
+
+    MeshLoader single  = MeshLoader(1);
+    MeshLoader pooled  = MeshLoader();
+    auto [mesh, error] = pooled.load(options.mesh);
     if (error.has_value()) {
         return wrap(error);
     }
-    auto [w, h]            = args;
-    const std::string name = "LearnOpenGL";
+    auto [expected, expected_error] = single.load(options.mesh);
+    if (expected_error.has_value()) {
+        return wrap(expected_error);
+    }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    constexpr size_t iterations = 10;
+    double single_ns            = measure(iterations, [&]() { single.load(options.mesh); });
+    double pooled_ns            = measure(iterations, [&]() { pooled.load(options.mesh); });
 
-    glfwWindowHintString(GLFW_X11_CLASS_NAME, ("float_" + name).c_str());
-    glfwWindowHintString(GLFW_X11_INSTANCE_NAME, ("float_" + name).c_str());
+    // vertices are plain floats, compared bit for bit
+    bool same = expected.indices == mesh.indices && expected.vertices.size() == mesh.vertices.size() &&
+                std::memcmp(expected.vertices.data(), mesh.vertices.data(), sizeof(Vertex) * mesh.vertices.size()) == 0;
 
-    GLFWwindow *window = glfwCreateWindow(w, h, name.c_str(), nullptr, nullptr);
-    if (! window) {
-        const char *error;
-        glfwGetError(&error);
+    const MeshLoader::Stats &stats = pooled.stats();
+    double megabytes               = stats.bytes / 1e6;
+    std::cout << "loading of " << options.mesh << ", " << megabytes << " MB in " << stats.tasks << " tasks, "
+              << iterations << " iterations\n";
+    report("1 thread", single_ns, "load");
+    report(std::to_string(pooled.threads()) + " threads (pool)", pooled_ns, "load");
+    std::cout << "  throughput         " << megabytes / (single_ns * 1e-9) << " MB/s on 1 thread, "
+              << megabytes / (pooled_ns * 1e-9) << " MB/s on " << pooled.threads() << " threads\n"
+              << "  triangles          " << mesh.indices.size() / 3 << "\n"
+              << "  vertices           " << mesh.vertices.size() << ", from " << stats.corners << " corners\n"
+              << "  same mesh          " << (same ? "yes" : "no") << "\n";
+    if (! same) {
+        return wrap("the pool loaded another mesh than a single thread");
+    }
+    return {};
+}
+
+// every light of the generated scene baked into a lightmap over its cubes, written to `options.bake`; runs without any
+// GL context
+Error bake_lightmap(const Options &options, const std::filesystem::path &cwd) {
+    const Scene scene                   = generate_scene(options.layout, options.cubes, options.lights, options.seed);
+    const std::vector<glm::mat4> models = cube_models(scene);
+    const std::vector<Light> lights     = point_lights(scene);
+    const LightmapSettings settings     = {options.texels, options.samples, options.bounces};
+
+    auto [albedo, albedo_error] = Albedo::from_file(cwd / "res/woodcontainer_steelborder.png");
+    if (albedo_error.has_value()) {
+        return wrap(albedo_error);
+    }
+
+    auto start                      = std::chrono::steady_clock::now();
+    auto [lightmap, lightmap_error] = Lightmap::bake(cube_mesh(settings.texels), models, lights, albedo, settings);
+    if (lightmap_error.has_value()) {
+        return wrap(lightmap_error);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "lightmap of " << models.size() << " cubes and " << lights.size() << " lights, " << settings.samples
+              << " paths per texel bouncing " << settings.bounces << " times\n"
+              << "  atlas              " << lightmap.width() << "x" << lightmap.height() << " texels, "
+              << settings.texels << " a face\n"
+              << "  threads            " << std::max(std::thread::hardware_concurrency(), 1u) << "\n"
+              << "  time               " << ms << " ms\n"
+              << "  rays               " << lightmap.rays() << ", " << lightmap.rays() / ms / 1000.0 << " M/s\n";
+    if (Error error = lightmap.save(options.bake); error.has_value()) {
         return wrap(error);
     }
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+    std::cout << "wrote lightmap to " << options.bake << "\n";
+    return {};
+}
 
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+Error run(int argc, char *argv[]) {
+    auto launch = std::chrono::steady_clock::now();
+    auto since  = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
 
-    control.last = 0.5f * glm::vec2(w, h);
+    auto [options, error] = from_args(argc, argv);
+    if (error.has_value()) {
+        return wrap(error);
+    }
+    int w                  = options.width;
+    int h                  = options.height;
+    const std::string name = "LearnOpenGL";
 
-    glfwSetFramebufferSizeCallback(window, viewport_resize);
-    glfwSetKeyCallback(window, Control::process_input);
-    glfwSetCursorPosCallback(window, Control::mouse);
-    glfwSetScrollCallback(window, Control::scroll);
+    if (options.bench == "clusters") {
+        return bench_clusters(options);
+    }
+    if (options.bench == "mesh") {
+        return bench_mesh(options);
+    }
+    if (! options.bake.empty()) {
+        return bake_lightmap(options, std::filesystem::path(argv[0]).parent_path());
+    }
 
-    if (! gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+    GLFWwindow *window                       = nullptr;
+    std::unique_ptr<HeadlessContext> context = nullptr;
+    GLADloadproc loader                      = (GLADloadproc) glfwGetProcAddress;
+    if (options.headless) {
+        auto [headless, headless_error] = HeadlessContext::create(4, 6);
+        if (headless_error.has_value()) {
+            return wrap(headless_error);
+        }
+        context = std::move(headless);
+        loader  = HeadlessContext::proc_address;
+    } else {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        glfwWindowHintString(GLFW_X11_CLASS_NAME, ("float_" + name).c_str());
+        glfwWindowHintString(GLFW_X11_INSTANCE_NAME, ("float_" + name).c_str());
+
+        window = glfwCreateWindow(w, h, name.c_str(), nullptr, nullptr);
+        if (! window) {
+            const char *error;
+            glfwGetError(&error);
+            return wrap(error);
+        }
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(1);
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        glfwSetFramebufferSizeCallback(window, viewport_resize);
+        glfwSetKeyCallback(window, Control::process_input);
+        glfwSetCursorPosCallback(window, Control::mouse);
+        glfwSetScrollCallback(window, Control::scroll);
+    }
+
+    control.last = 0.5f * glm::vec2(w, h);
+    control.draw_path(options.draw_path);
+    control.shading(options.shading);
+
+    if (! gladLoadGLLoader(loader)) {
         return wrap("failed to initialize GLAD");
     }
+    const bool parallel = Shader::parallel_compile(loader);
 
     std::cout << "OpenGL\n"
               << "  Vendor  \t" << glGetString(GL_VENDOR) << "\n"
@@ -145,45 +757,141 @@ Error run(int argc, char *argv[]) {
     glm::vec3 origin = {0.0f, 0.0f, 0.0f};
     glm::vec3 ux {1.0f, 0.0f, 0.0f}, uy {0.0f, 1.0f, 0.0f}, uz {0.0f, 0.0f, 1.0f};
 
-    std::vector<glm::vec3> cube_positions = {
-        glm::vec3(0.0f, 0.0f, 0.0f),
-        glm::vec3(2.0f, 5.0f, -15.0f),
-        glm::vec3(-1.5f, -2.2f, -2.5f),
-        glm::vec3(-3.8f, -2.0f, -12.3f),
-        glm::vec3(2.4f, -0.4f, -3.5f),
-        glm::vec3(-1.7f, 3.0f, -7.5f),
-        glm::vec3(1.3f, -2.0f, -2.5f),
-        glm::vec3(1.5f, 2.0f, -2.5f),
-        glm::vec3(1.5f, 0.2f, -1.5f),
-        glm::vec3(-1.3f, 1.0f, -1.5f),
-    };
+    const Scene scene = generate_scene(options.layout, options.cubes, options.lights, options.seed);
+
+    const std::vector<glm::vec3> &cube_positions                    = scene.cube_positions;
+    const std::vector<std::pair<glm::vec3, glm::vec3>> &lights_data = scene.lights;
+    std::cout << "scene\n"
+              << "  cubes   \t" << cube_positions.size() << "\n"
+              << "  lights  \t" << lights_data.size() << "\n";
+
+    glm::vec3 white = glm::vec3(1.0f);
+    float far       = far_plane(scene);
+
+    // the cubes' lights baked for this very scene, the lightmap is refused otherwise
+    std::unique_ptr<LightmapTexture> lightmap = nullptr;
+    unsigned int lightmap_texels              = LightmapSettings {}.texels;
+    if (! options.lightmap.empty()) {
+        auto [baked, lightmap_error] = Lightmap::load(options.lightmap);
+        if (lightmap_error.has_value()) {
+            return wrap(lightmap_error);
+        }
+        if (baked.key() != Lightmap::key(cube_models(scene), point_lights(scene))) {
+            return wrap(options.lightmap + " was baked for another scene, bake it again with --bake");
+        }
+        std::cout << "lightmap\n"
+                  << "  atlas   \t" << baked.width() << "x" << baked.height() << " texels, " << baked.texels()
+                  << " a face\n"
+                  << "  baked   \t" << baked.settings().samples << " paths per texel, " << baked.settings().bounces
+                  << " bounces\n";
+        lightmap_texels = baked.texels();
+        lightmap        = std::make_unique<LightmapTexture>(baked);
+        control.lightmap(true);
+    }
+
+    Vertices cube_vertices = cube_mesh(lightmap_texels);
+    Vertices lines         = line(origin, ux, 1.0f, ux) + line(origin, uy, 1.0f, uy) + line(origin, uz, 1.0f, uz);
+
+    // static meshes of the indirect path, each object picks its data in `objects` through its command's base instance
+    MeshPool pool = {{{cube_vertices, quad_indices(cube_vertices)}, {lines, line_indices(lines)}}};
+    const PooledMesh &pooled_cube = pool[0], &pooled_lines = pool[1];
+
+    std::vector<ObjectStd430> objects                 = {};
+    std::vector<DrawElementsIndirectCommand> commands = {};
+    // every cube is an instance of a single command
+    commands.push_back(indirect_command(pooled_cube, objects.size(), cube_positions.size()));
+    for (size_t i = 0; i < cube_positions.size(); ++i) {
+        glm::mat4 model = cube_model(i, cube_positions[i]);
+        objects.push_back({model, glm::transpose(glm::inverse(model))});
+    }
+    // one instance per enabled light, the instance count follows `control.light_count()`
+    const size_t proxies_command = commands.size();
+    commands.push_back(indirect_command(pooled_cube, objects.size(), 0));
+    for (auto [light_position, light_color] : lights_data) {
+        objects.push_back({
+            .model = glm::scale(glm::translate(glm::mat4(1.0f), light_position), glm::vec3(0.2f)),
+            .color = glm::vec4(light_color, 1.0f),
+        });
+    }
+    const size_t lines_command = commands.size();
+    commands.push_back(indirect_command(pooled_lines, objects.size()));
+    objects.push_back({});
+
+    StorageBuffer objects_ssbo    = {objects.size() * sizeof(ObjectStd430), objects_binding, objects.data()};
+    IndirectBuffer indirect       = {std::move(commands)};
+    unsigned int indirect_proxies = 0;
 
-    Vertices cube_vertices = cube(cube_positions[0], ux, uy, uz, 1.0f);
     IndexBuffer ib         = {quad_indices(cube_vertices)};
+    IndexBuffer ib_volumes = {outward_indices(cube_vertices)};
     VertexBuffer vb        = {std::move(cube_vertices)};
     VertexArray va         = {vb};
     VertexArray va_lights  = {vb};
 
+    Instances cube_instances = {};
+    cube_instances.reserve(cube_positions.size());
+    for (size_t i = 0; i < cube_positions.size(); ++i) {
+        glm::mat4 model = cube_model(i, cube_positions[i]);
+        cube_instances.push_back({model, glm::transpose(glm::inverse(model))});
+    }
+    InstanceBuffer instances = {std::move(cube_instances)};
+    VertexArray va_instanced = {vb, instances};
+
     glEnable(GL_LINE_SMOOTH);
-    Vertices lines        = line(origin, ux, 1.0f, ux) + line(origin, uy, 1.0f, uy) + line(origin, uz, 1.0f, uz);
     IndexBuffer ib_lines  = {line_indices(lines)};
     VertexBuffer vb_lines = {std::move(lines)};
     VertexArray va_lines  = {vb_lines};
 
-    auto [shader, shader_error] = Shader::from_files(cwd / "res/shader.vert", cwd / "res/shader.frag");
-    if (shader_error.has_value()) {
-        return wrap(shader_error);
+    if (options.program_cache) {
+        ProgramCache::open(cwd / "cache");
     }
+    auto programs_start = std::chrono::steady_clock::now();
 
-    auto [shader_light, shader_light_error] = Shader::from_files(cwd / "res/shader.vert", cwd / "res/light.frag");
-    if (shader_light_error.has_value()) {
-        return wrap(shader_light_error);
-    }
+    // every cube program comes in two permutations, the flashlight one adding the camera's spot light
+    const Defines cube_defines = {{"TEXTURED", ""}};
+    Defines flashlight_defines = cube_defines;
+    flashlight_defines.push_back({"FLASHLIGHT", ""});
 
-    auto [shader_lines, shader_lines_error] = Shader::from_files(cwd / "res/shader.vert", cwd / "res/lines.frag");
-    if (shader_lines_error.has_value()) {
-        return wrap(shader_lines_error);
-    }
+    // every program is submitted before any is waited for, the driver compiles them while the textures load
+    ProgramFuture shader_future                      =
+        Shader::compile(cwd / "res/shader.vert", cwd / "res/shader.frag", cube_defines);
+    ProgramFuture shader_flashlight_future           =
+        Shader::compile(cwd / "res/shader.vert", cwd / "res/shader.frag", flashlight_defines);
+    ProgramFuture shader_instanced_future            =
+        Shader::compile(cwd / "res/instanced.vert", cwd / "res/shader.frag", cube_defines);
+    ProgramFuture shader_instanced_flashlight_future =
+        Shader::compile(cwd / "res/instanced.vert", cwd / "res/shader.frag", flashlight_defines);
+    ProgramFuture shader_indirect_future             =
+        Shader::compile(cwd / "res/indirect.vert", cwd / "res/shader.frag", cube_defines);
+    ProgramFuture shader_indirect_flashlight_future  =
+        Shader::compile(cwd / "res/indirect.vert", cwd / "res/shader.frag", flashlight_defines);
+
+    // deferred shading draws the cubes into the G-buffer with the same vertex shaders, then lights it in passes of its
+    // own: a full screen one for the background and the flashlight, and one volume per light
+    ProgramFuture shader_gbuffer_future           =
+        Shader::compile(cwd / "res/shader.vert", cwd / "res/gbuffer.frag", cube_defines);
+    ProgramFuture shader_gbuffer_instanced_future =
+        Shader::compile(cwd / "res/instanced.vert", cwd / "res/gbuffer.frag", cube_defines);
+    ProgramFuture shader_gbuffer_indirect_future  =
+        Shader::compile(cwd / "res/indirect.vert", cwd / "res/gbuffer.frag", cube_defines);
+    const Defines deferred_flashlight_defines       = {{"FLASHLIGHT", ""}};
+    const Defines deferred_volume_defines           = {{"VOLUME", ""}};
+    ProgramFuture shader_deferred_future            =
+        Shader::compile(cwd / "res/deferred.vert", cwd / "res/deferred.frag");
+    ProgramFuture shader_deferred_flashlight_future =
+        Shader::compile(cwd / "res/deferred.vert", cwd / "res/deferred.frag", deferred_flashlight_defines);
+    ProgramFuture shader_deferred_volume_future     =
+        Shader::compile(cwd / "res/deferred.vert", cwd / "res/deferred.frag", deferred_volume_defines);
+
+    // shadow casters; cube maps take a geometry stage rendering the six faces in a single pass
+    const Defines shadow_cube_defines       = {{"CUBE", ""}};
+    ProgramFuture shader_shadow_spot_future = Shader::compile(cwd / "res/shadow.vert", cwd / "res/shadow.frag");
+    ProgramFuture shader_shadow_cube_future =
+        Shader::compile(cwd / "res/shadow.vert", cwd / "res/shadow.geom", cwd / "res/shadow.frag", shadow_cube_defines);
+
+    ProgramFuture shader_indirect_flat_future = Shader::compile(cwd / "res/indirect.vert", cwd / "res/lines.frag");
+    ProgramFuture shader_light_future         = Shader::compile(cwd / "res/shader.vert", cwd / "res/light.frag");
+    ProgramFuture shader_lines_future         = Shader::compile(cwd / "res/shader.vert", cwd / "res/lines.frag");
+    const double programs_submit              = since(programs_start);
 
     auto [texture_container, texture_container_error] = Texture::from_file(cwd / "res/woodcontainer_steelborder.png",
         GL_TEXTURE0,
@@ -209,23 +917,524 @@ Error run(int argc, char *argv[]) {
     if (texture_specular_error.has_value()) {
         return wrap(texture_specular_error);
     }
+    const double textures_ready = since(programs_start);
 
-    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-    while (! glfwWindowShouldClose(window)) {
-        float now = glfwGetTime();
-        delta_t   = now - previous;
-        previous  = now;
+    auto [shader, shader_error] = shader_future.get();
+    if (shader_error.has_value()) {
+        return wrap(shader_error);
+    }
 
-        camera.position(camera.position() + 5.0f * control.movement_direction() * delta_t);
-        glm::mat4 projection = glm::perspective(camera.fov(), (float) w / (float) h, 0.1f, 100.f);
+    auto [shader_flashlight, shader_flashlight_error] = shader_flashlight_future.get();
+    if (shader_flashlight_error.has_value()) {
+        return wrap(shader_flashlight_error);
+    }
 
-        glm::vec3 white                                          = glm::vec3(1.0f);
-        std::vector<std::pair<glm::vec3, glm::vec3>> lights_data = {
-            {{0.7f, 0.2f, 2.0f}, white},
-            {{2.3f, -3.3f, -4.0f}, glm::vec3(1.0f, 0.0f, 0.0f)},
-            {{-4.0f, 2.0f, -12.0f}, glm::vec3(0.0f, 1.0f, 0.0f)},
-            {{0.0f, 0.0f, -3.0f}, glm::vec3(0.0f, 0.0f, 1.0f)},
-        };
+    auto [shader_instanced, shader_instanced_error] = shader_instanced_future.get();
+    if (shader_instanced_error.has_value()) {
+        return wrap(shader_instanced_error);
+    }
+
+    auto [shader_instanced_flashlight, shader_instanced_flashlight_error] = shader_instanced_flashlight_future.get();
+    if (shader_instanced_flashlight_error.has_value()) {
+        return wrap(shader_instanced_flashlight_error);
+    }
+
+    auto [shader_indirect, shader_indirect_error] = shader_indirect_future.get();
+    if (shader_indirect_error.has_value()) {
+        return wrap(shader_indirect_error);
+    }
+
+    auto [shader_indirect_flashlight, shader_indirect_flashlight_error] = shader_indirect_flashlight_future.get();
+    if (shader_indirect_flashlight_error.has_value()) {
+        return wrap(shader_indirect_flashlight_error);
+    }
+
+    auto [shader_gbuffer, shader_gbuffer_error] = shader_gbuffer_future.get();
+    if (shader_gbuffer_error.has_value()) {
+        return wrap(shader_gbuffer_error);
+    }
+
+    auto [shader_gbuffer_instanced, shader_gbuffer_instanced_error] = shader_gbuffer_instanced_future.get();
+    if (shader_gbuffer_instanced_error.has_value()) {
+        return wrap(shader_gbuffer_instanced_error);
+    }
+
+    auto [shader_gbuffer_indirect, shader_gbuffer_indirect_error] = shader_gbuffer_indirect_future.get();
+    if (shader_gbuffer_indirect_error.has_value()) {
+        return wrap(shader_gbuffer_indirect_error);
+    }
+
+    auto [shader_deferred, shader_deferred_error] = shader_deferred_future.get();
+    if (shader_deferred_error.has_value()) {
+        return wrap(shader_deferred_error);
+    }
+
+    auto [shader_deferred_flashlight, shader_deferred_flashlight_error] = shader_deferred_flashlight_future.get();
+    if (shader_deferred_flashlight_error.has_value()) {
+        return wrap(shader_deferred_flashlight_error);
+    }
+
+    auto [shader_deferred_volume, shader_deferred_volume_error] = shader_deferred_volume_future.get();
+    if (shader_deferred_volume_error.has_value()) {
+        return wrap(shader_deferred_volume_error);
+    }
+
+    auto [shader_shadow_spot, shader_shadow_spot_error] = shader_shadow_spot_future.get();
+    if (shader_shadow_spot_error.has_value()) {
+        return wrap(shader_shadow_spot_error);
+    }
+
+    auto [shader_shadow_cube, shader_shadow_cube_error] = shader_shadow_cube_future.get();
+    if (shader_shadow_cube_error.has_value()) {
+        return wrap(shader_shadow_cube_error);
+    }
+
+    auto [shader_indirect_flat, shader_indirect_flat_error] = shader_indirect_flat_future.get();
+    if (shader_indirect_flat_error.has_value()) {
+        return wrap(shader_indirect_flat_error);
+    }
+
+    auto [shader_light, shader_light_error] = shader_light_future.get();
+    if (shader_light_error.has_value()) {
+        return wrap(shader_light_error);
+    }
+
+    auto [shader_lines, shader_lines_error] = shader_lines_future.get();
+    if (shader_lines_error.has_value()) {
+        return wrap(shader_lines_error);
+    }
+
+    const ProgramCache::Stats &cache = ProgramCache::stats();
+    std::cout << "programs\n"
+              << "  cache   \t";
+    if (ProgramCache::enabled()) {
+        std::cout << cache.hits << " hits, " << cache.misses << " misses, " << cache.stale << " stale ("
+                  << (cache.misses == 0 ? "warm" : "cold") << ")\n";
+    } else {
+        std::cout << "off\n";
+    }
+    std::cout << "  parallel\t" << (parallel ? "yes" : "no") << "\n"
+              << "  submit  \t" << programs_submit << " ms\n"
+              << "  textures\t" << textures_ready << " ms\n"
+              << "  startup \t" << since(programs_start) << " ms\n";
+
+    auto [cube_uniforms, cube_uniforms_error] = CubeUniforms::from_shader(shader, true);
+    if (cube_uniforms_error.has_value()) {
+        return wrap(cube_uniforms_error);
+    }
+
+    auto [cube_flashlight_uniforms, cube_flashlight_uniforms_error] =
+        CubeUniforms::from_shader(shader_flashlight, true);
+    if (cube_flashlight_uniforms_error.has_value()) {
+        return wrap(cube_flashlight_uniforms_error);
+    }
+
+    auto [cube_instanced_uniforms, cube_instanced_uniforms_error] = CubeUniforms::from_shader(shader_instanced, false);
+    if (cube_instanced_uniforms_error.has_value()) {
+        return wrap(cube_instanced_uniforms_error);
+    }
+
+    auto [cube_instanced_flashlight_uniforms, cube_instanced_flashlight_uniforms_error] =
+        CubeUniforms::from_shader(shader_instanced_flashlight, false);
+    if (cube_instanced_flashlight_uniforms_error.has_value()) {
+        return wrap(cube_instanced_flashlight_uniforms_error);
+    }
+
+    auto [cube_indirect_uniforms, cube_indirect_uniforms_error] = CubeUniforms::from_shader(shader_indirect, false);
+    if (cube_indirect_uniforms_error.has_value()) {
+        return wrap(cube_indirect_uniforms_error);
+    }
+
+    auto [cube_indirect_flashlight_uniforms, cube_indirect_flashlight_uniforms_error] =
+        CubeUniforms::from_shader(shader_indirect_flashlight, false);
+    if (cube_indirect_flashlight_uniforms_error.has_value()) {
+        return wrap(cube_indirect_flashlight_uniforms_error);
+    }
+
+    auto [gbuffer_uniforms, gbuffer_uniforms_error] = CubeUniforms::from_shader(shader_gbuffer, true);
+    if (gbuffer_uniforms_error.has_value()) {
+        return wrap(gbuffer_uniforms_error);
+    }
+
+    auto [gbuffer_instanced_uniforms, gbuffer_instanced_uniforms_error] =
+        CubeUniforms::from_shader(shader_gbuffer_instanced, false);
+    if (gbuffer_instanced_uniforms_error.has_value()) {
+        return wrap(gbuffer_instanced_uniforms_error);
+    }
+
+    auto [gbuffer_indirect_uniforms, gbuffer_indirect_uniforms_error] =
+        CubeUniforms::from_shader(shader_gbuffer_indirect, false);
+    if (gbuffer_indirect_uniforms_error.has_value()) {
+        return wrap(gbuffer_indirect_uniforms_error);
+    }
+
+    auto [deferred_uniforms, deferred_uniforms_error] = DeferredUniforms::from_shader(shader_deferred, false);
+    if (deferred_uniforms_error.has_value()) {
+        return wrap(deferred_uniforms_error);
+    }
+
+    auto [deferred_flashlight_uniforms, deferred_flashlight_uniforms_error] =
+        DeferredUniforms::from_shader(shader_deferred_flashlight, false);
+    if (deferred_flashlight_uniforms_error.has_value()) {
+        return wrap(deferred_flashlight_uniforms_error);
+    }
+
+    auto [deferred_volume_uniforms, deferred_volume_uniforms_error] =
+        DeferredUniforms::from_shader(shader_deferred_volume, true);
+    if (deferred_volume_uniforms_error.has_value()) {
+        return wrap(deferred_volume_uniforms_error);
+    }
+
+    auto [shadow_spot_uniforms, shadow_spot_uniforms_error] = ShadowUniforms::from_shader(shader_shadow_spot, false);
+    if (shadow_spot_uniforms_error.has_value()) {
+        return wrap(shadow_spot_uniforms_error);
+    }
+
+    auto [shadow_cube_uniforms, shadow_cube_uniforms_error] = ShadowUniforms::from_shader(shader_shadow_cube, true);
+    if (shadow_cube_uniforms_error.has_value()) {
+        return wrap(shadow_cube_uniforms_error);
+    }
+
+    if (Error error = shader_indirect_flat.check_block("Camera", camera_binding, sizeof(CameraStd140));
+        error.has_value()) {
+        return wrap(error);
+    }
+
+    // whether the cubes read their static lights from the lightmap this frame
+    bool baked = false;
+
+    // uniforms shared by every cube of a frame, whatever the draw path; the camera comes from its own block
+    auto set_cube_uniforms = [&](Shader &program, const CubeUniforms &uniforms) {
+        program.set(uniforms.material_shininess, 64.0f);
+        program.set(uniforms.material_diffuse, texture_container.slot());
+        program.set(uniforms.material_specular, texture_specular.slot());
+        program.set(uniforms.lightmap_enabled, baked);
+        if (lightmap) {
+            program.set(uniforms.lightmap_columns, lightmap->layout().columns);
+            program.set(uniforms.lightmap_tile_width, lightmap->layout().tile_width);
+            program.set(uniforms.lightmap_tile_height, lightmap->layout().tile_height);
+        }
+    };
+
+    auto set_shadow_uniforms = [](Shader &program, const ShadowUniforms &uniforms, const ShadowPass &pass) {
+        if (pass.cube >= 0) {
+            for (size_t face = 0; face < uniforms.faces.size(); ++face) {
+                program.set(uniforms.faces[face], pass.view_projections[face]);
+            }
+            program.set(uniforms.cube, pass.cube);
+        } else {
+            program.set(uniforms.view_projection, pass.view_projections[0]);
+        }
+        program.set(uniforms.light_position, pass.position);
+        program.set(uniforms.far, pass.far);
+    };
+
+    if (options.bench == "uniforms") {
+        constexpr size_t iterations = 100000;
+
+        glm::mat4 model = cube_model(0, cube_positions[0]);
+        shader.bind();
+
+        Error names_error = {};
+        double names      = measure(iterations, [&]() {
+            names_error = shader.set_uniforms({
+                {"u_model", model},
+                {"u_ti_model", glm::transpose(glm::inverse(model))},
+
+                {"u_material.shininess", 64.0f},
+                {"u_material.diffuse", texture_container.slot()},
+                {"u_material.specular", texture_specular.slot()},
+            });
+        });
+        if (names_error.has_value()) {
+            return wrap(names_error);
+        }
+
+        double handles = measure(iterations, [&]() {
+            set_cube_uniforms(shader, cube_uniforms);
+            shader.set(cube_uniforms.model, model);
+            shader.set(cube_uniforms.ti_model, glm::transpose(glm::inverse(model)));
+        });
+        glFinish();
+
+        std::cout << "uniform upload of one cube draw, " << iterations << " iterations\n";
+        report("set_uniforms (names)", names, "draw");
+        report("set (handles)", handles, "draw");
+        return {};
+    }
+
+    auto [light_uniforms, light_uniforms_error] = ProxyUniforms::from_shader(shader_light, true);
+    if (light_uniforms_error.has_value()) {
+        return wrap(light_uniforms_error);
+    }
+
+    auto [lines_uniforms, lines_uniforms_error] = ProxyUniforms::from_shader(shader_lines, false);
+    if (lines_uniforms_error.has_value()) {
+        return wrap(lines_uniforms_error);
+    }
+
+    RenderQueue queue = {};
+
+    auto [cube_material, cube_material_error] = queue.add_material({
+        &shader,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, cube_uniforms); },
+        [&](Shader &program, const Object &object) {
+            program.set(cube_uniforms.model, object.model);
+            program.set(cube_uniforms.ti_model, glm::transpose(glm::inverse(object.model)));
+        },
+    });
+    auto [cube_flashlight_material, cube_flashlight_material_error] = queue.add_material({
+        &shader_flashlight,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, cube_flashlight_uniforms); },
+        [&](Shader &program, const Object &object) {
+            program.set(cube_flashlight_uniforms.model, object.model);
+            program.set(cube_flashlight_uniforms.ti_model, glm::transpose(glm::inverse(object.model)));
+        },
+    });
+    auto [cube_instanced_material, cube_instanced_material_error] = queue.add_material({
+        &shader_instanced,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, cube_instanced_uniforms); },
+        {},
+    });
+    auto [cube_instanced_flashlight_material, cube_instanced_flashlight_material_error] = queue.add_material({
+        &shader_instanced_flashlight,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, cube_instanced_flashlight_uniforms); },
+        {},
+    });
+    auto [gbuffer_material, gbuffer_material_error] = queue.add_material({
+        &shader_gbuffer,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, gbuffer_uniforms); },
+        [&](Shader &program, const Object &object) {
+            program.set(gbuffer_uniforms.model, object.model);
+            program.set(gbuffer_uniforms.ti_model, glm::transpose(glm::inverse(object.model)));
+        },
+    });
+    auto [gbuffer_instanced_material, gbuffer_instanced_material_error] = queue.add_material({
+        &shader_gbuffer_instanced,
+        {texture_container, texture_specular},
+        [&](Shader &program) { set_cube_uniforms(program, gbuffer_instanced_uniforms); },
+        {},
+    });
+    // the G-buffer textures are bound by the shading pass itself
+    auto [deferred_volume_material, deferred_volume_material_error] =
+        queue.add_material({&shader_deferred_volume, {}, {}, {}});
+    auto [light_material, light_material_error] = queue.add_material({
+        &shader_light,
+        {},
+        {},
+        [&](Shader &program, const Object &object) {
+            program.set(light_uniforms.model, object.model);
+            program.set(light_uniforms.light_color, glm::vec3(object.color));
+        },
+    });
+    auto [lines_material, lines_material_error] = queue.add_material({
+        &shader_lines,
+        {},
+        {},
+        [&](Shader &program, const Object &object) { program.set(lines_uniforms.model, object.model); },
+    });
+
+    auto [cube_mesh, cube_mesh_error]                     = queue.add_mesh({Primitive::TRIANGLES, &va, &ib});
+    auto [cube_instanced_mesh, cube_instanced_mesh_error] = queue.add_mesh({Primitive::TRIANGLES, &va_instanced, &ib});
+    auto [light_mesh, light_mesh_error]                   = queue.add_mesh({Primitive::TRIANGLES, &va_lights, &ib});
+    auto [lines_mesh, lines_mesh_error]                   = queue.add_mesh({Primitive::LINES, &va_lines, &ib_lines});
+    // light volumes cull their front faces, every face of their cube is wound outward
+    auto [volume_mesh, volume_mesh_error] = queue.add_mesh({Primitive::TRIANGLES, &va_lights, &ib_volumes});
+
+    for (Error error : {cube_material_error,
+             cube_flashlight_material_error,
+             cube_instanced_material_error,
+             cube_instanced_flashlight_material_error,
+             gbuffer_material_error,
+             gbuffer_instanced_material_error,
+             deferred_volume_material_error,
+             light_material_error,
+             lines_material_error,
+             cube_mesh_error,
+             cube_instanced_mesh_error,
+             light_mesh_error,
+             volume_mesh_error,
+             lines_mesh_error}) {
+        if (error.has_value()) {
+            return wrap(error);
+        }
+    }
+
+    RenderQueue::Stats queue_stats = {};
+    StateCache::Stats state_stats  = {};
+    RingBuffer::Stats ring_stats   = {};
+    unsigned int frames            = 0;
+
+    LightClusters clusters = {};
+
+    // the lights stay in their storage block from frame to frame, only those that change are written again
+    LightRegistry registry                = {lights_data.size()};
+    std::vector<LightHandle> scene_lights = {};
+    LightRegistry::Stats light_stats      = {};
+    unsigned int object_lights_revision   = ~0u;
+
+    // the first point lights of the scene and the flashlight cast shadows, their maps cached until they go stale
+    ShadowAtlas shadows = {};
+    if (Error error = shadows.status(); error.has_value()) {
+        return wrap(error);
+    }
+    ShadowAtlas::Stats shadow_stats = {};
+    int flashlight_shadow           = -1;
+
+    // cubes and lights never move, the lists of the objects only change with the lights on
+    std::vector<Sphere> cube_bounds = {};
+    for (const glm::vec3 &position : cube_positions) {
+        cube_bounds.push_back({position, 0.5f * std::sqrt(3.0f)});
+    }
+    ObjectLights object_lights        = {std::move(cube_bounds)};
+    StorageBuffer object_light_ranges = {object_lights.size() * sizeof(glm::uvec2), object_light_ranges_binding};
+    // grown as needed, never empty since a storage block cannot be bound to an empty range
+    std::unique_ptr<StorageBuffer> object_light_indices = nullptr;
+    size_t object_light_capacity                        = 0;
+
+    // per-frame data, written straight into mapped memory: the cluster ranges and as many light indices as the
+    // clusters can list, on top of the camera
+    const size_t cluster_indices = std::min(lights_data.size(), max_cluster_lights) * clusters.size();
+    RingBuffer stream            = {(1 << 16) + sizeof(ClustersStd430) + clusters.size() * sizeof(glm::uvec2) +
+                         cluster_indices * sizeof(uint32_t)};
+    if (Error error = stream.status(); error.has_value()) {
+        return wrap(error);
+    }
+    GpuTimer timer = {};
+
+    // headless runs draw into their own framebuffer and log every frame
+    std::unique_ptr<Framebuffer> framebuffer = nullptr;
+    // created the first time deferred shading is on, then follows the viewport size
+    std::unique_ptr<GBuffer> gbuffer = nullptr;
+    std::vector<FrameRecord> records = {};
+    if (options.headless) {
+        framebuffer = std::make_unique<Framebuffer>(w, h);
+        if (Error error = framebuffer->status(); error.has_value()) {
+            return wrap(error);
+        }
+        glViewport(0, 0, w, h);
+        records.reserve(options.frames);
+        // every light of the scene is on, there is no one to press N
+        control.light_count(lights_data.size());
+    }
+
+    const std::vector<Reloadable> reloadables = {
+        {&shader, cwd / "res/shader.vert", cwd / "res/shader.frag", cube_defines, adopt(cube_uniforms, true)},
+        {&shader_flashlight,
+            cwd / "res/shader.vert",
+            cwd / "res/shader.frag",
+            flashlight_defines,
+            adopt(cube_flashlight_uniforms, true)},
+        {&shader_instanced,
+            cwd / "res/instanced.vert",
+            cwd / "res/shader.frag",
+            cube_defines,
+            adopt(cube_instanced_uniforms, false)},
+        {&shader_instanced_flashlight,
+            cwd / "res/instanced.vert",
+            cwd / "res/shader.frag",
+            flashlight_defines,
+            adopt(cube_instanced_flashlight_uniforms, false)},
+        {&shader_indirect,
+            cwd / "res/indirect.vert",
+            cwd / "res/shader.frag",
+            cube_defines,
+            adopt(cube_indirect_uniforms, false)},
+        {&shader_indirect_flashlight,
+            cwd / "res/indirect.vert",
+            cwd / "res/shader.frag",
+            flashlight_defines,
+            adopt(cube_indirect_flashlight_uniforms, false)},
+        {&shader_gbuffer,
+            cwd / "res/shader.vert",
+            cwd / "res/gbuffer.frag",
+            cube_defines,
+            adopt(gbuffer_uniforms, true)},
+        {&shader_gbuffer_instanced,
+            cwd / "res/instanced.vert",
+            cwd / "res/gbuffer.frag",
+            cube_defines,
+            adopt(gbuffer_instanced_uniforms, false)},
+        {&shader_gbuffer_indirect,
+            cwd / "res/indirect.vert",
+            cwd / "res/gbuffer.frag",
+            cube_defines,
+            adopt(gbuffer_indirect_uniforms, false)},
+        {&shader_deferred, cwd / "res/deferred.vert", cwd / "res/deferred.frag", {}, adopt(deferred_uniforms, false)},
+        {&shader_deferred_flashlight,
+            cwd / "res/deferred.vert",
+            cwd / "res/deferred.frag",
+            deferred_flashlight_defines,
+            adopt(deferred_flashlight_uniforms, false)},
+        {&shader_deferred_volume,
+            cwd / "res/deferred.vert",
+            cwd / "res/deferred.frag",
+            deferred_volume_defines,
+            adopt(deferred_volume_uniforms, true)},
+        {&shader_shadow_spot,
+            cwd / "res/shadow.vert",
+            cwd / "res/shadow.frag",
+            {},
+            adopt(shadow_spot_uniforms, false)},
+        {&shader_shadow_cube,
+            cwd / "res/shadow.vert",
+            cwd / "res/shadow.frag",
+            shadow_cube_defines,
+            adopt(shadow_cube_uniforms, true),
+            cwd / "res/shadow.geom"},
+        {&shader_indirect_flat,
+            cwd / "res/indirect.vert",
+            cwd / "res/lines.frag",
+            {},
+            [](Shader &program) { return program.check_block("Camera", camera_binding, sizeof(CameraStd140)); }},
+        {&shader_light, cwd / "res/shader.vert", cwd / "res/light.frag", {}, adopt(light_uniforms, true)},
+        {&shader_lines, cwd / "res/shader.vert", cwd / "res/lines.frag", {}, adopt(lines_uniforms, false)},
+    };
+
+    // headless runs are benchmarks, nobody edits shaders under them
+    std::unique_ptr<ShaderWatcher> watcher = nullptr;
+    if (! options.headless) {
+        auto [shader_watcher, watcher_error] = ShaderWatcher::watch(cwd / "res");
+        if (watcher_error.has_value()) {
+            std::cerr << "shader hot reload disabled: " << watcher_error.value() << "\n";
+        }
+        watcher = std::move(shader_watcher);
+    }
+
+    // deferred shading writes it over every texel the cubes leave uncovered
+    const glm::vec3 background = glm::vec3(0.2f);
+    glClearColor(background.r, background.g, background.b, 1.0f);
+    StateCache::frame();
+    Shader::uniform_frame();
+    while (options.headless ? frames < options.frames : ! glfwWindowShouldClose(window)) {
+        auto start = std::chrono::steady_clock::now();
+        if (watcher) {
+            reload(reloadables, watcher->changes());
+        }
+        stream.begin();
+
+        if (options.headless) {
+            // one orbit around the cube field over the whole run, identical from one run to the next
+            float t = (float) frames / (float) options.frames;
+            headless_camera(camera, scene, t);
+        } else {
+            float now = glfwGetTime();
+            delta_t   = now - previous;
+            previous  = now;
+
+            camera.position(camera.position() + 5.0f * control.movement_direction() * delta_t);
+        }
+        // the camera block is the only place programs get the camera from, computed once for all of them
+        CameraStd140 camera_block = std140(camera, glm::perspective(camera.fov(), (float) w / (float) h, near, far));
+        if (Error error = stream.push(GL_UNIFORM_BUFFER, camera_binding, &camera_block, sizeof(camera_block));
+            error.has_value()) {
+            return wrap(error);
+        }
 
         Light flashlight = {
             glm::vec4(camera.position(), 1.0f),
@@ -241,91 +1450,301 @@ Error run(int argc, char *argv[]) {
             0.032f,
         };
 
-        int nlights               = std::min(control.light_count(), (int) lights_data.size());
-        std::vector<Light> lights = {};
-        std::vector<std::pair<glm::vec3, glm::vec3>> visible_lights = {};
-        for (int i = 0; i < nlights; ++i) {
-            auto [light_position, light_color] = lights_data[i];
-            lights.push_back({
-                .position  = glm::vec4(light_position, 1.0f),
-                .ambient   = 0.2f * light_color,
-                .diffuse   = 0.5f * light_color,
-                .specular  = light_color,
-                .linear    = 0.09f,
-                .quadratic = 0.032f,
-            });
-            visible_lights.push_back({light_position, light_color});
-        };
-        if (control.flashlight()) {
-            lights.push_back(flashlight);
-            nlights += 1;
+        int nlights = std::min(control.light_count(), (int) lights_data.size());
+        // N stops adding lights once the scene has none left
+        control.light_count(nlights);
+        // N turns the lights of the scene on and off in order, the last one on goes first
+        while (scene_lights.size() < (size_t) nlights) {
+            auto [light_position, light_color] = lights_data[scene_lights.size()];
+            Light light                        = point_light(light_position, light_color, scene.attenuation);
+            light.shadow                       = shadows.add(light, false);
+            scene_lights.push_back(registry.add(light));
+        }
+        while (scene_lights.size() > (size_t) nlights) {
+            shadows.remove(registry[scene_lights.back()].shadow);
+            registry.remove(scene_lights.back());
+            scene_lights.pop_back();
+        }
+        bool flashlight_on = control.flashlight();
+        if (flashlight_on) {
+            // only written again, and its map rendered again, when the camera moved or turned; without a free tile the
+            // flashlight casts no shadow and asks again next frame
+            if (flashlight_shadow < 0) {
+                flashlight_shadow = shadows.add(flashlight, true);
+            } else {
+                shadows.set(flashlight_shadow, flashlight);
+            }
+            flashlight.shadow = flashlight_shadow;
+            registry.flashlight(flashlight);
+        } else {
+            // its tile goes back to the atlas, taken again and rendered anew when the flashlight comes back on
+            shadows.remove(flashlight_shadow);
+            flashlight_shadow = -1;
         }
+        light_stats += registry.upload();
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // the stale shadow maps within the frame's budget, every cube casting through the indirect path's first
+        // command whatever the draw path
+        std::vector<ShadowPass> shadow_passes = shadows.schedule(options.shadow_budget);
+        if (! shadow_passes.empty()) {
+            timer.begin(Pass::SHADOWS);
+            pool.va().bind();
+            pool.ib().bind();
+            for (const ShadowPass &pass : shadow_passes) {
+                Shader &program = pass.cube >= 0 ? shader_shadow_cube : shader_shadow_spot;
+                program.bind();
+                set_shadow_uniforms(program, pass.cube >= 0 ? shadow_cube_uniforms : shadow_spot_uniforms, pass);
+                shadows.begin(pass);
+                indirect.draw(Primitive::TRIANGLES, 0, 1);
+                shadows.end();
+            }
+            timer.end(Pass::SHADOWS);
+        }
+        shadow_stats += shadows.frame();
+        shadows.bind_textures();
+        if (lightmap) {
+            lightmap->bind();
+        }
 
-        for (size_t i = 0; i < cube_positions.size(); ++i) {
-            const auto &cube_position = cube_positions[i];
-            glm::mat4 model =
-                glm::rotate(glm::translate(glm::mat4(1.0f), cube_position), i * pi / 8.0f, glm::vec3(1.0f, 0.3f, 0.5f));
-            if (error = draw(Primitive::TRIANGLES,
-                    va,
-                    ib,
-                    shader,
-                    {
-                        {"u_model", model},
-                        {"u_ti_model", glm::transpose(glm::inverse(model))},
-                        {"u_view", camera.view()},
-                        {"u_projection", projection},
-                        {"u_view_position", camera.position()},
-
-                        {"u_material.color", glm::vec4(1.0f, 0.5f, 0.0f, 0.0f)},
-                        {"u_material.shininess", 64.0f},
-
-                        {"u_nlights", std::min(nlights, 8)},
-                    },
-                    {{
-                        {"u_material.diffuse", texture_container},
-                        {"u_material.specular", texture_specular},
-                    }},
-                    lights);
-                error.has_value()) {
-                return wrap(error);
+        int viewport[4] = {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        // the clusters only serve forward shading, deferred shading bounds each light by its own volume
+        const bool deferred = control.shading() == Shading::DEFERRED;
+        // deferred shading keeps evaluating every light
+        baked = lightmap && control.lightmap() && ! deferred;
+        if (deferred) {
+            if (! gbuffer || gbuffer->width() != viewport[2] || gbuffer->height() != viewport[3]) {
+                gbuffer = std::make_unique<GBuffer>(viewport[2], viewport[3]);
+                if (Error error = gbuffer->status(); error.has_value()) {
+                    return wrap(error);
+                }
+            }
+            gbuffer->bind();
+            gbuffer->clear();
+        } else {
+            clusters.assign(registry.lights(),
+                registry.size(),
+                {camera_block.view, camera.fov(), (float) w / (float) h, near, far});
+
+            const std::vector<glm::uvec2> &ranges = clusters.ranges();
+            const std::vector<uint32_t> &indices  = clusters.indices();
+            auto [clusters_block, clusters_error] = stream.allocate(GL_SHADER_STORAGE_BUFFER,
+                clusters_binding,
+                sizeof(ClustersStd430) + ranges.size() * sizeof(glm::uvec2));
+            if (clusters_error.has_value()) {
+                return wrap(clusters_error);
+            }
+            *static_cast<ClustersStd430 *>(clusters_block) = clusters.std430({viewport[2], viewport[3]});
+            std::memcpy(static_cast<char *>(clusters_block) + sizeof(ClustersStd430),
+                ranges.data(),
+                ranges.size() * sizeof(glm::uvec2));
+
+            // a storage block cannot be bound to an empty range
+            auto [indices_block, indices_error] = stream.allocate(GL_SHADER_STORAGE_BUFFER,
+                cluster_lights_binding,
+                std::max(indices.size(), (size_t) 1) * sizeof(uint32_t));
+            if (indices_error.has_value()) {
+                return wrap(indices_error);
+            }
+            std::memcpy(indices_block, indices.data(), indices.size() * sizeof(uint32_t));
+
+            if (registry.revision() != object_lights_revision) {
+                object_lights_revision = registry.revision();
+                object_lights.assign(registry.lights(), registry.size());
+                object_light_ranges.write(
+                    object_lights.ranges().data(), object_lights.ranges().size() * sizeof(glm::uvec2));
+
+                const std::vector<uint32_t> &object_indices = object_lights.indices();
+                if (! object_light_indices || object_indices.size() > object_light_capacity) {
+                    object_light_capacity = std::max(object_indices.size(), (size_t) 1);
+                    object_light_indices  = std::make_unique<StorageBuffer>(
+                        object_light_capacity * sizeof(uint32_t), object_lights_binding);
+                }
+                object_light_indices->write(object_indices.data(), object_indices.size() * sizeof(uint32_t));
+            }
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
+        if (control.draw_path() == DrawPath::INDIRECT) {
+            if (indirect_proxies != (unsigned int) nlights) {
+                indirect_proxies = nlights;
+                indirect.write(proxies_command, indirect_command(pooled_cube, cube_positions.size(), indirect_proxies));
+            }
+
+            pool.va().bind();
+            pool.ib().bind();
+
+            timer.begin(Pass::CUBES);
+            Shader &program              = deferred        ? shader_gbuffer_indirect
+                                           : flashlight_on ? shader_indirect_flashlight
+                                                           : shader_indirect;
+            const CubeUniforms &uniforms = deferred        ? gbuffer_indirect_uniforms
+                                           : flashlight_on ? cube_indirect_flashlight_uniforms
+                                                           : cube_indirect_uniforms;
+            program.bind();
+            texture_container.bind();
+            texture_specular.bind();
+            set_cube_uniforms(program, uniforms);
+            indirect.draw(Primitive::TRIANGLES, 0, proxies_command);
+            timer.end(Pass::CUBES);
+        } else {
+            // one submission per pass so that each can be timed; passes never share a program, sorting across them
+            // would not save any switch
+            timer.begin(Pass::CUBES);
+            if (control.draw_path() == DrawPath::INSTANCED) {
+                queue.push(deferred        ? gbuffer_instanced_material
+                           : flashlight_on ? cube_instanced_flashlight_material
+                                           : cube_instanced_material,
+                    cube_instanced_mesh,
+                    0.0f,
+                    {.instances = instances.count()});
+            } else {
+                for (size_t i = 0; i < cube_positions.size(); ++i) {
+                    queue.push(deferred        ? gbuffer_material
+                               : flashlight_on ? cube_flashlight_material
+                                               : cube_material,
+                        cube_mesh,
+                        glm::distance(camera.position(), cube_positions[i]),
+                        {.model = cube_model(i, cube_positions[i]), .base_instance = (unsigned int) i});
+                }
+            }
+            queue_stats += queue.submit();
+            timer.end(Pass::CUBES);
+        }
+
+        if (deferred) {
+            // lit into the output framebuffer, whose depth the light proxies and the lines are then tested against
+            if (framebuffer) {
+                framebuffer->bind();
+            } else {
+                gbuffer->unbind();
+            }
+            gbuffer->blit_depth();
+
+            timer.begin(Pass::SHADING);
+            gbuffer->bind_textures();
+            glDepthMask(GL_FALSE);
+
+            // every texel once: the background, or the flashlight when it is on and black otherwise
+            glDisable(GL_DEPTH_TEST);
+            Shader &base                     = flashlight_on ? shader_deferred_flashlight : shader_deferred;
+            const DeferredUniforms &uniforms = flashlight_on ? deferred_flashlight_uniforms : deferred_uniforms;
+            base.bind();
+            base.set(uniforms.background, background);
+            va_lights.bind();
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            // then the light volumes add up, only where their far side lies behind the G-buffer depth: front faces are
+            // culled so that each texel shades once per light, and depth clamping keeps the far sides past the far
+            // plane instead of clipping them
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_GEQUAL);
+            glEnable(GL_DEPTH_CLAMP);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            if (unsigned int volumes = registry.size(); volumes > 0) {
+                queue.push(deferred_volume_material, volume_mesh, 0.0f, {.instances = volumes});
+                queue_stats += queue.submit();
             }
+            glDisable(GL_BLEND);
+            glDisable(GL_CULL_FACE);
+            glCullFace(GL_BACK);
+            glDisable(GL_DEPTH_CLAMP);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+            timer.end(Pass::SHADING);
         }
 
-        for (auto [light_position, light_color] : visible_lights) {
-            if (error = draw(Primitive::TRIANGLES,
-                    va_lights,
-                    ib,
-                    shader_light,
+        if (control.draw_path() == DrawPath::INDIRECT) {
+            pool.va().bind();
+            pool.ib().bind();
+
+            timer.begin(Pass::LIGHTS);
+            shader_indirect_flat.bind();
+            indirect.draw(Primitive::TRIANGLES, proxies_command, 1);
+            timer.end(Pass::LIGHTS);
+
+            timer.begin(Pass::LINES);
+            indirect.draw(Primitive::LINES, lines_command, 1);
+            timer.end(Pass::LINES);
+        } else {
+            timer.begin(Pass::LIGHTS);
+
+            for (int i = 0; i < nlights; ++i) {
+                auto [light_position, light_color] = lights_data[i];
+                queue.push(light_material,
+                    light_mesh,
+                    glm::distance(camera.position(), light_position),
                     {
-                        {"u_model", glm::scale(glm::translate(glm::mat4(1.0f), light_position), glm::vec3(0.2f))},
-                        {"u_view", camera.view()},
-                        {"u_projection", projection},
-                        {"u_light_color", light_color},
+                        .model = glm::scale(glm::translate(glm::mat4(1.0f), light_position), glm::vec3(0.2f)),
+                        .color = glm::vec4(light_color, 1.0f),
                     });
-                error.has_value()) {
-                return wrap(error);
             }
+            queue_stats += queue.submit();
+            timer.end(Pass::LIGHTS);
+
+            timer.begin(Pass::LINES);
+            queue.push(lines_material, lines_mesh, glm::distance(camera.position(), origin), {});
+            queue_stats += queue.submit();
+            timer.end(Pass::LINES);
         }
 
-        if (error = draw(Primitive::LINES,
-                va_lines,
-                ib_lines,
-                shader_lines,
-                {
-                    {"u_model", glm::mat4(1.0f)},
-                    {"u_view", camera.view()},
-                    {"u_projection", projection},
-                });
-            error.has_value()) {
-            return wrap(error);
+        std::optional<GpuTimer::Times> times = timer.frame();
+        state_stats += StateCache::frame();
+        state_stats.uniform += Shader::uniform_frame();
+        ring_stats += stream.end();
+        frames += 1;
+
+        if (frames == 1) {
+            // waiting once is what it takes to know when the first frame is really done
+            glFinish();
+            std::cout << "first frame after " << since(launch) << " ms\n";
+        }
+
+        if (options.headless) {
+            // nothing is presented, flushing stands in for the swap so that queries and fences make progress
+            glFlush();
+            double cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            records.push_back({cpu_ms, {}});
+            if (times.has_value()) {
+                records[times->frame].gpu = times;
+            }
+        } else {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
         }
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (options.headless) {
+        for (const GpuTimer::Times &times : timer.flush()) {
+            records[times.frame].gpu = times;
+        }
+        RunInfo info = {
+            {"renderer", reinterpret_cast<const char *>(glGetString(GL_RENDERER))},
+            {"draw_path", option_name(draw_paths, options.draw_path)},
+            {"shading", option_name(shadings, options.shading)},
+            {"scene", option_name(layouts, options.layout)},
+            {"cubes", std::to_string(cube_positions.size())},
+            {"lights", std::to_string(lights_data.size())},
+            {"seed", std::to_string(options.seed)},
+            {"lightmap", lightmap ? options.lightmap : "none"},
+            {"resolution", std::to_string(w) + "x" + std::to_string(h)},
+        };
+        if (Error error = write_frames(options.output, info, records); error.has_value()) {
+            return wrap(error);
+        }
+        std::cout << "wrote " << records.size() << " frames to " << options.output << "\n";
     }
 
+    report(queue_stats, frames);
+    report(state_stats, frames);
+    report(ring_stats, frames);
+    report(light_stats, frames);
+    report(shadow_stats, frames);
+    report(timer);
     return {};
 }
 
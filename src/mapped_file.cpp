@@ -0,0 +1,61 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+}
+
+std::pair<MappedFile, Error> MappedFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return {MappedFile {}, wrap("could not open " + path + ": " + std::strerror(errno))};
+    }
+
+    struct stat status = {};
+    if (fstat(fd, &status) < 0) {
+        Error error = wrap("could not open " + path + ": " + std::strerror(errno));
+        close(fd);
+        return {MappedFile {}, error};
+    }
+
+    MappedFile file = {};
+    // mapping nothing fails, an empty file is an empty view
+    if (status.st_size > 0) {
+        void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            Error error = wrap("could not open " + path + ": " + std::strerror(errno));
+            close(fd);
+            return {MappedFile {}, error};
+        }
+        // the whole file is about to be read, by several threads at once
+        madvise(data, status.st_size, MADV_WILLNEED);
+        file.m_data = static_cast<const char *>(data);
+        file.m_size = status.st_size;
+    }
+    // the mapping outlives its descriptor
+    close(fd);
+    return {std::move(file), Error {}};
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        if (m_data != nullptr) {
+            munmap(const_cast<char *>(m_data), m_size);
+        }
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
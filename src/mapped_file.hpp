@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "error.hpp"
+
+// File mapped read only into memory, its pages are read from the disk on their first access, from any thread.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    static std::pair<MappedFile, Error> open(const std::string &path);
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::string_view view() const { return {m_data, m_size}; }
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &other)            = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+  private:
+    const char *m_data = nullptr;
+    size_t m_size      = 0;
+};
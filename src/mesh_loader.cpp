@@ -0,0 +1,838 @@
+#include "mesh_loader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <optional>
+
+#include "json.hpp"
+#include "mapped_file.hpp"
+
+// index of a corner missing its texture coordinates or normal
+constexpr static int absent = -1;
+
+// position, texture coordinates and normal of a face corner
+using ObjCorner = std::array<int, 3>;
+
+// A line aligned piece of an OBJ file, parsed on its own. Indices count from the start of the file, relative ones
+// (negative in the file) from the start of the chunk until the elements of the previous chunks are counted.
+struct ObjChunk {
+    std::string_view text;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec2> tex;
+    std::vector<glm::vec3> normals;
+
+    // three per triangle
+    std::vector<ObjCorner> corners;
+    // `corner * 3 + attribute` of the relative indices
+    std::vector<uint32_t> relative;
+    // whether any corner lacks a normal
+    bool smooth = false;
+
+    // lines parsed, up to the one of `error`
+    size_t lines = 0;
+    Error error  = {};
+
+    Vertices vertices;
+    Indices indices;
+};
+
+// attributes of the whole file
+struct ObjAttributes {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec2> tex;
+    std::vector<glm::vec3> normals;
+    // per position, for the corners without a normal
+    std::vector<glm::vec3> smooth;
+};
+
+static bool blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && blank(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static glm::vec3 normalize_or_zero(glm::vec3 v) {
+    float length = glm::length(v);
+    return length > 0.0f ? v / length : v;
+}
+
+// reads up to `N` numbers following `p` on its line, returns how many
+template <size_t N> static size_t parse_floats(const char *&p, const char *end, std::array<float, N> &values) {
+    size_t count = 0;
+    for (; count < N; ++count) {
+        p = skip_blanks(p, end);
+        if (p < end && *p == '+') {
+            p++;
+        }
+        auto [next, error] = std::from_chars(p, end, values[count]);
+        // out of range values are kept as whatever they rounded to
+        if (error == std::errc::invalid_argument) {
+            break;
+        }
+        p = next;
+    }
+    return count;
+}
+
+// index of the corner at `p`, from 1 onwards or negative from the last element read, into 0 onwards from the start of
+// the file or, when `relative`, of the chunk
+static bool parse_index(const char *&p, const char *end, size_t count, int &index, bool &relative) {
+    int raw            = 0;
+    auto [next, error] = std::from_chars(p, end, raw);
+    if (error != std::errc() || raw == 0) {
+        return false;
+    }
+    p        = next;
+    relative = raw < 0;
+    index    = relative ? (int) count + raw : raw - 1;
+    return true;
+}
+
+// `f` line, its polygon split in a fan of triangles
+static Error parse_face(ObjChunk &chunk, const char *p, const char *end, std::vector<ObjCorner> &polygon,
+    std::vector<std::array<bool, 3>> &relative) {
+    polygon.clear();
+    relative.clear();
+    while ((p = skip_blanks(p, end)) < end) {
+        ObjCorner corner                = {absent, absent, absent};
+        std::array<bool, 3> is_relative = {false, false, false};
+        if (! parse_index(p, end, chunk.positions.size(), corner[0], is_relative[0])) {
+            return "malformed face corner";
+        }
+        if (p < end && *p == '/') {
+            p++;
+            if (p < end && *p != '/' && ! parse_index(p, end, chunk.tex.size(), corner[1], is_relative[1])) {
+                return "malformed face texture coordinates";
+            }
+            if (p < end && *p == '/') {
+                p++;
+                if (! parse_index(p, end, chunk.normals.size(), corner[2], is_relative[2])) {
+                    return "malformed face normal";
+                }
+            }
+        }
+        if (p < end && ! blank(*p)) {
+            return "malformed face corner";
+        }
+        chunk.smooth |= corner[2] == absent;
+        polygon.push_back(corner);
+        relative.push_back(is_relative);
+    }
+    if (polygon.size() < 3) {
+        return "face of less than 3 corners";
+    }
+
+    for (size_t i = 2; i < polygon.size(); ++i) {
+        for (size_t j : {(size_t) 0, i - 1, i}) {
+            for (uint32_t attribute = 0; attribute < 3; ++attribute) {
+                if (relative[j][attribute]) {
+                    chunk.relative.push_back(chunk.corners.size() * 3 + attribute);
+                }
+            }
+            chunk.corners.push_back(polygon[j]);
+        }
+    }
+    return {};
+}
+
+// keywords other than `v`, `vt`, `vn` and `f` are skipped: objects, groups, materials and free form geometry
+static Error parse_line(ObjChunk &chunk, const char *p, const char *end, std::vector<ObjCorner> &polygon,
+    std::vector<std::array<bool, 3>> &relative) {
+    p = skip_blanks(p, end);
+    if (p == end || *p == '#') {
+        return {};
+    }
+    const char *word = p;
+    while (p < end && ! blank(*p)) {
+        p++;
+    }
+    std::string_view keyword = {word, (size_t) (p - word)};
+
+    std::array<float, 6> values = {};
+    if (keyword == "v") {
+        size_t count = parse_floats(p, end, values);
+        if (count < 3) {
+            return "vertex position of less than 3 coordinates";
+        }
+        chunk.positions.emplace_back(values[0], values[1], values[2]);
+        chunk.colors.push_back(count == 6 ? glm::vec3(values[3], values[4], values[5]) : glm::vec3(1.0f));
+    } else if (keyword == "vt") {
+        if (parse_floats(p, end, values) < 1) {
+            return "texture coordinates of no value";
+        }
+        chunk.tex.emplace_back(values[0], 1.0f - values[1]);
+    } else if (keyword == "vn") {
+        if (parse_floats(p, end, values) < 3) {
+            return "normal of less than 3 coordinates";
+        }
+        chunk.normals.emplace_back(values[0], values[1], values[2]);
+    } else if (keyword == "f") {
+        return parse_face(chunk, p, end, polygon, relative);
+    }
+    return {};
+}
+
+static void parse_chunk(ObjChunk &chunk) {
+    std::vector<ObjCorner> polygon            = {};
+    std::vector<std::array<bool, 3>> relative = {};
+
+    const char *p = chunk.text.data(), *end = p + chunk.text.size();
+    while (p < end) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        eol             = eol != nullptr ? eol : end;
+        if (Error error = parse_line(chunk, p, eol, polygon, relative); error.has_value()) {
+            chunk.error = error;
+            return;
+        }
+        chunk.lines++;
+        p = eol + 1;
+    }
+}
+
+static uint64_t hash(const ObjCorner &corner) {
+    uint64_t h = (uint32_t) corner[0] * 0x9e3779b97f4a7c15ull ^ (uint32_t) corner[1] * 0xc2b2ae3d27d4eb4full ^
+                 (uint32_t) corner[2] * 0x165667b19e3779f9ull;
+    return h ^ h >> 29;
+}
+
+// one vertex per distinct corner of the chunk, found in an open addressing table
+static void dedupe(ObjChunk &chunk, const ObjAttributes &attributes) {
+    constexpr uint32_t empty = UINT32_MAX;
+    const size_t mask        = std::bit_ceil(std::max<size_t>(2 * chunk.corners.size(), 16)) - 1;
+    std::vector<uint32_t> slots(mask + 1, empty);
+    std::vector<ObjCorner> keys = {};
+
+    chunk.indices.reserve(chunk.corners.size());
+    for (const ObjCorner &corner : chunk.corners) {
+        size_t slot = hash(corner) & mask;
+        while (slots[slot] != empty && keys[slots[slot]] != corner) {
+            slot = (slot + 1) & mask;
+        }
+        if (slots[slot] == empty) {
+            slots[slot] = keys.size();
+            keys.push_back(corner);
+
+            auto [position, tex, normal] = corner;
+            Vertex vertex                = {};
+            vertex.r                     = attributes.positions[position];
+            vertex.color                 = attributes.colors[position];
+            vertex.t                     = tex != absent ? attributes.tex[tex] : glm::vec2(0.0f);
+            vertex.normal                = normal != absent ? attributes.normals[normal] : attributes.smooth[position];
+            chunk.vertices.push_back(vertex);
+        }
+        chunk.indices.push_back(slots[slot]);
+    }
+}
+
+// elements of `chunks` gathered in a single array, in order
+template <typename T>
+static void gather(std::vector<T> &out, const std::vector<ObjChunk> &chunks, std::vector<T> ObjChunk::*member,
+    const std::vector<size_t> &offsets, size_t i) {
+    const std::vector<T> &elements = chunks[i].*member;
+    std::copy(elements.begin(), elements.end(), out.begin() + offsets[i]);
+}
+
+std::pair<MeshData, Error> MeshLoader::load_obj(const std::string &path) {
+    auto [file, error] = MappedFile::open(path);
+    if (error.has_value()) {
+        return {{}, wrap(error)};
+    }
+
+    std::vector<ObjChunk> chunks = {};
+    const char *data             = file.data();
+    for (size_t begin = 0, end = 0; begin < file.size(); begin = end) {
+        end = std::min(begin + obj_chunk_size, file.size());
+        // through the end of its last line
+        const char *eol = static_cast<const char *>(std::memchr(data + end - 1, '\n', file.size() - end + 1));
+        end             = eol != nullptr ? eol - data + 1 : file.size();
+        chunks.emplace_back().text = {data + begin, end - begin};
+    }
+    m_stats.bytes = file.size();
+    m_stats.tasks = chunks.size();
+
+    m_pool.run(chunks.size(), [&](size_t i) { parse_chunk(chunks[i]); });
+
+    // offsets of each chunk's elements in those of the file
+    std::vector<size_t> positions(chunks.size() + 1, 0), tex(chunks.size() + 1, 0), normals(chunks.size() + 1, 0);
+    size_t lines = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (chunks[i].error.has_value()) {
+            return {{}, wrap(path + ":" + std::to_string(lines + chunks[i].lines + 1) + ": " + *chunks[i].error)};
+        }
+        lines += chunks[i].lines;
+        positions[i + 1] = positions[i] + chunks[i].positions.size();
+        tex[i + 1]       = tex[i] + chunks[i].tex.size();
+        normals[i + 1]   = normals[i] + chunks[i].normals.size();
+        m_stats.corners += chunks[i].corners.size();
+    }
+
+    ObjAttributes attributes = {};
+    attributes.positions.resize(positions.back());
+    attributes.colors.resize(positions.back());
+    attributes.tex.resize(tex.back());
+    attributes.normals.resize(normals.back());
+    m_pool.run(chunks.size(), [&](size_t i) {
+        gather(attributes.positions, chunks, &ObjChunk::positions, positions, i);
+        gather(attributes.colors, chunks, &ObjChunk::colors, positions, i);
+        gather(attributes.tex, chunks, &ObjChunk::tex, tex, i);
+        gather(attributes.normals, chunks, &ObjChunk::normals, normals, i);
+
+        ObjChunk &chunk                    = chunks[i];
+        const std::array<size_t, 3> offset = {positions[i], tex[i], normals[i]};
+        const std::array<size_t, 3> counts = {positions.back(), tex.back(), normals.back()};
+        for (uint32_t relative : chunk.relative) {
+            int &index = chunk.corners[relative / 3][relative % 3];
+            index += offset[relative % 3];
+            if (index < 0) {
+                chunk.error = "face index before the first element";
+            }
+        }
+        for (const ObjCorner &corner : chunk.corners) {
+            if (corner[0] < 0) {
+                chunk.error = "face without a position";
+            }
+            for (size_t attribute = 0; attribute < 3; ++attribute) {
+                if (corner[attribute] >= (int64_t) counts[attribute]) {
+                    chunk.error = "face index out of range";
+                }
+            }
+        }
+    });
+    for (const ObjChunk &chunk : chunks) {
+        if (chunk.error.has_value()) {
+            return {{}, wrap(path + ": " + *chunk.error)};
+        }
+    }
+
+    // a single pass over every face, only for files missing normals
+    if (std::any_of(chunks.begin(), chunks.end(), [](const ObjChunk &chunk) { return chunk.smooth; })) {
+        attributes.smooth.assign(positions.back(), glm::vec3(0.0f));
+        for (const ObjChunk &chunk : chunks) {
+            for (size_t i = 0; i < chunk.corners.size(); i += 3) {
+                int a = chunk.corners[i][0], b = chunk.corners[i + 1][0], c = chunk.corners[i + 2][0];
+                // weighted by the area of the face
+                glm::vec3 normal = glm::cross(attributes.positions[b] - attributes.positions[a],
+                    attributes.positions[c] - attributes.positions[a]);
+                attributes.smooth[a] += normal;
+                attributes.smooth[b] += normal;
+                attributes.smooth[c] += normal;
+            }
+        }
+        for (glm::vec3 &normal : attributes.smooth) {
+            normal = normalize_or_zero(normal);
+        }
+    }
+
+    m_pool.run(chunks.size(), [&](size_t i) { dedupe(chunks[i], attributes); });
+
+    std::vector<size_t> vertices(chunks.size() + 1, 0), indices(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        vertices[i + 1] = vertices[i] + chunks[i].vertices.size();
+        indices[i + 1]  = indices[i] + chunks[i].indices.size();
+    }
+    MeshData mesh = {};
+    mesh.vertices.resize(vertices.back());
+    mesh.indices.resize(indices.back());
+    m_pool.run(chunks.size(), [&](size_t i) {
+        const ObjChunk &chunk = chunks[i];
+        std::copy(chunk.vertices.begin(), chunk.vertices.end(), mesh.vertices.begin() + vertices[i]);
+        std::transform(chunk.indices.begin(),
+            chunk.indices.end(),
+            mesh.indices.begin() + indices[i],
+            [offset = vertices[i]](unsigned int index) { return index + offset; });
+    });
+    return {std::move(mesh), {}};
+}
+
+// glTF component types
+constexpr static int gltf_byte           = 5120;
+constexpr static int gltf_unsigned_byte  = 5121;
+constexpr static int gltf_short          = 5122;
+constexpr static int gltf_unsigned_short = 5123;
+constexpr static int gltf_unsigned_int   = 5125;
+constexpr static int gltf_float          = 5126;
+
+constexpr static int gltf_triangles = 4;
+
+// bytes of each component type, components of each element type
+static const std::map<int, size_t> gltf_sizes = {
+    {gltf_byte, 1},
+    {gltf_unsigned_byte, 1},
+    {gltf_short, 2},
+    {gltf_unsigned_short, 2},
+    {gltf_unsigned_int, 4},
+    {gltf_float, 4},
+};
+static const std::map<std::string, int> gltf_components = {{"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4}};
+
+// chunk types of .glb files
+constexpr static uint32_t glb_magic = 0x46546c67;
+constexpr static uint32_t glb_json  = 0x4e4f534a;
+constexpr static uint32_t glb_bin   = 0x004e4942;
+
+// elements of a glTF accessor, straight from its buffer
+struct GltfAccessor {
+    // null for accessors without a buffer view, all zeros
+    const unsigned char *data = nullptr;
+    size_t stride             = 0;
+    size_t count              = 0;
+    int type                  = gltf_float;
+    int components            = 1;
+    bool normalized           = false;
+
+    float component(size_t i, int c) const {
+        if (data == nullptr) {
+            return 0.0f;
+        }
+        const unsigned char *p = data + i * stride;
+        switch (type) {
+        case gltf_byte:
+            return normalized ? std::max((int8_t) p[c] / 127.0f, -1.0f) : (int8_t) p[c];
+        case gltf_unsigned_byte:
+            return normalized ? p[c] / 255.0f : p[c];
+        case gltf_short: {
+            int16_t value = 0;
+            std::memcpy(&value, p + 2 * c, sizeof(value));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+        }
+        case gltf_unsigned_short: {
+            uint16_t value = 0;
+            std::memcpy(&value, p + 2 * c, sizeof(value));
+            return normalized ? value / 65535.0f : value;
+        }
+        case gltf_unsigned_int: {
+            uint32_t value = 0;
+            std::memcpy(&value, p + 4 * c, sizeof(value));
+            return value;
+        }
+        default: {
+            float value = 0.0f;
+            std::memcpy(&value, p + 4 * c, sizeof(value));
+            return value;
+        }
+        }
+    }
+
+    glm::vec4 operator[](size_t i) const {
+        glm::vec4 value = glm::vec4(0.0f);
+        for (int c = 0; c < components; ++c) {
+            value[c] = component(i, c);
+        }
+        return value;
+    }
+
+    uint32_t index(size_t i) const {
+        if (data == nullptr) {
+            return 0;
+        }
+        const unsigned char *p = data + i * stride;
+        uint16_t u16           = 0;
+        uint32_t u32           = 0;
+        switch (type) {
+        case gltf_unsigned_byte:
+            return p[0];
+        case gltf_unsigned_short:
+            std::memcpy(&u16, p, sizeof(u16));
+            return u16;
+        default:
+            std::memcpy(&u32, p, sizeof(u32));
+            return u32;
+        }
+    }
+};
+
+// a triangle primitive of a mesh, once for every node drawing it
+struct GltfPrimitive {
+    glm::mat4 model;
+    glm::mat3 normal_model;
+    // whether the model matrix mirrors the primitive, turning its triangles the other way round
+    bool mirrored;
+
+    GltfAccessor positions;
+    std::optional<GltfAccessor> normals, tex, colors, indices;
+    // triangles, from `indices` or from consecutive vertices
+    size_t triangles;
+
+    size_t first_vertex;
+    size_t first_index;
+};
+
+// vertices or triangles of a primitive converted by a task
+struct GltfRange {
+    size_t primitive;
+    bool triangles;
+    size_t begin;
+    size_t end;
+};
+
+// non negative integer, or `fallback`
+static size_t integer(const Json &json, size_t fallback) {
+    return json.type == Json::Type::NUMBER && json.number >= 0.0 ? (size_t) json.number : fallback;
+}
+
+static std::pair<GltfAccessor, Error> accessor(
+    const Json &gltf, const std::vector<std::string_view> &buffers, size_t index) {
+    const Json &json = gltf["accessors"][index];
+    if (json.is_null()) {
+        return {{}, "missing accessor " + std::to_string(index)};
+    }
+    if (! json["sparse"].is_null()) {
+        return {{}, "sparse accessors are not supported"};
+    }
+
+    GltfAccessor out = {};
+    out.count        = integer(json["count"], 0);
+    out.type         = integer(json["componentType"], 0);
+    out.normalized   = json["normalized"].boolean;
+    if (! gltf_components.contains(json["type"].string) || ! gltf_sizes.contains(out.type)) {
+        return {{}, "accessor " + std::to_string(index) + " of unsupported type " + json["type"].string};
+    }
+    out.components = gltf_components.at(json["type"].string);
+
+    const Json &view = gltf["bufferViews"][integer(json["bufferView"], SIZE_MAX)];
+    if (view.is_null() || out.count == 0) {
+        return {out, {}};
+    }
+    size_t buffer = integer(view["buffer"], SIZE_MAX);
+    size_t start  = integer(view["byteOffset"], 0);
+    size_t length = integer(view["byteLength"], 0);
+    size_t offset = integer(json["byteOffset"], 0);
+    size_t size   = gltf_sizes.at(out.type) * out.components;
+    out.stride    = integer(view["byteStride"], size);
+    if (buffer >= buffers.size() || start + length > buffers[buffer].size() ||
+        offset + out.stride * (out.count - 1) + size > length) {
+        return {{}, "accessor " + std::to_string(index) + " out of its buffer"};
+    }
+    out.data = reinterpret_cast<const unsigned char *>(buffers[buffer].data()) + start + offset;
+    return {out, {}};
+}
+
+static std::optional<GltfAccessor> attribute(const Json &gltf, const std::vector<std::string_view> &buffers,
+    const Json &attributes, const std::string &name, Error &error) {
+    if (attributes[name].is_null() || error.has_value()) {
+        return {};
+    }
+    auto [out, accessor_error] = accessor(gltf, buffers, integer(attributes[name], SIZE_MAX));
+    error                      = accessor_error;
+    return out;
+}
+
+// local transform of a node, its matrix or its translation, rotation and scale
+static glm::mat4 node_matrix(const Json &node) {
+    glm::mat4 matrix = glm::mat4(1.0f);
+    if (node["matrix"].size() == 16) {
+        for (int i = 0; i < 16; ++i) {
+            matrix[i / 4][i % 4] = node["matrix"][i].number_or(0.0);
+        }
+        return matrix;
+    }
+    const Json &t = node["translation"], &r = node["rotation"], &s = node["scale"];
+    float x = r[0].number_or(0.0), y = r[1].number_or(0.0), z = r[2].number_or(0.0), w = r[3].number_or(1.0);
+    // of the unit quaternion (x, y, z, w)
+    glm::mat4 rotation = {
+        {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f},
+        {2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f},
+        {2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f},
+        {0.0f, 0.0f, 0.0f, 1.0f},
+    };
+    matrix = glm::translate(matrix, glm::vec3(t[0].number_or(0.0), t[1].number_or(0.0), t[2].number_or(0.0)));
+    return glm::scale(matrix * rotation, glm::vec3(s[0].number_or(1.0), s[1].number_or(1.0), s[2].number_or(1.0)));
+}
+
+static std::vector<char> base64(std::string_view text) {
+    std::vector<char> out = {};
+    uint32_t bits = 0, count = 0;
+    for (char c : text) {
+        int value = c >= 'A' && c <= 'Z'   ? c - 'A'
+                    : c >= 'a' && c <= 'z' ? c - 'a' + 26
+                    : c >= '0' && c <= '9' ? c - '0' + 52
+                    : c == '+'             ? 62
+                    : c == '/'             ? 63
+                                           : -1;
+        // padding
+        if (value < 0) {
+            break;
+        }
+        bits = bits << 6 | value;
+        if ((count += 6) >= 8) {
+            count -= 8;
+            out.push_back(char(bits >> count & 0xff));
+        }
+    }
+    return out;
+}
+
+// relative URIs of buffers escape some characters, spaces as %20
+static std::string unescape(const std::string &uri) {
+    std::string out = {};
+    for (size_t i = 0; i < uri.size(); ++i) {
+        unsigned int code = 0;
+        if (uri[i] == '%' && i + 2 < uri.size() &&
+            std::from_chars(uri.data() + i + 1, uri.data() + i + 3, code, 16).ptr == uri.data() + i + 3) {
+            out += char(code);
+            i += 2;
+        } else {
+            out += uri[i];
+        }
+    }
+    return out;
+}
+
+std::pair<MeshData, Error> MeshLoader::load_gltf(const std::string &path, bool binary) {
+    auto [file, error] = MappedFile::open(path);
+    if (error.has_value()) {
+        return {{}, wrap(error)};
+    }
+    m_stats.bytes = file.size();
+
+    // a .glb file is a header, a JSON chunk, and a binary chunk holding the first buffer
+    std::string_view text = file.view(), bin = {};
+    if (binary) {
+        uint32_t header[5] = {};
+        if (file.size() < sizeof(header)) {
+            return {{}, wrap(path + ": truncated binary glTF")};
+        }
+        std::memcpy(header, file.data(), sizeof(header));
+        if (header[0] != glb_magic || header[1] != 2 || header[4] != glb_json ||
+            sizeof(header) + header[3] > file.size()) {
+            return {{}, wrap(path + ": not a binary glTF 2.0 file")};
+        }
+        text              = file.view().substr(sizeof(header), header[3]);
+        size_t offset     = sizeof(header) + (header[3] + 3) / 4 * 4;
+        uint32_t chunk[2] = {};
+        if (offset + sizeof(chunk) <= file.size()) {
+            std::memcpy(chunk, file.data() + offset, sizeof(chunk));
+            if (chunk[1] == glb_bin) {
+                bin = file.view().substr(offset + sizeof(chunk), chunk[0]);
+            }
+        }
+    }
+
+    auto [gltf, json_error] = Json::parse(text);
+    if (json_error.has_value()) {
+        return {{}, wrap(path + ": " + *json_error)};
+    }
+    if (! gltf["extensionsRequired"].is_null()) {
+        return {{}, wrap(path + ": required glTF extensions are not supported")};
+    }
+
+    std::vector<MappedFile> files           = {};
+    std::vector<std::vector<char>> embedded = {};
+    std::vector<std::string_view> buffers   = {};
+    for (size_t i = 0; i < gltf["buffers"].size(); ++i) {
+        const Json &buffer    = gltf["buffers"][i];
+        const Json &uri       = buffer["uri"];
+        size_t length         = integer(buffer["byteLength"], 0);
+        std::string_view data = {};
+        if (uri.is_null() && binary && i == 0) {
+            data = bin;
+        } else if (uri.string.starts_with("data:")) {
+            size_t comma = uri.string.find(',');
+            embedded.push_back(base64(std::string_view(uri.string).substr(comma == std::string::npos ? 0 : comma + 1)));
+            data = {embedded.back().data(), embedded.back().size()};
+        } else if (! uri.string.empty()) {
+            std::filesystem::path relative   = std::filesystem::path(path).parent_path() / unescape(uri.string);
+            auto [buffer_file, buffer_error] = MappedFile::open(relative.string());
+            if (buffer_error.has_value()) {
+                return {{}, wrap(buffer_error)};
+            }
+            m_stats.bytes += buffer_file.size();
+            data = buffer_file.view();
+            files.push_back(std::move(buffer_file));
+        }
+        if (data.size() < length) {
+            return {{}, wrap(path + ": buffer " + std::to_string(i) + " shorter than its byteLength")};
+        }
+        buffers.push_back(data.substr(0, length));
+    }
+
+    // every mesh under the nodes of the default scene, or every mesh as it is without any scene
+    std::vector<std::pair<size_t, glm::mat4>> meshes = {};
+    const Json &scene                                = gltf["scenes"][integer(gltf["scene"], 0)];
+    if (scene.is_null()) {
+        for (size_t i = 0; i < gltf["meshes"].size(); ++i) {
+            meshes.emplace_back(i, glm::mat4(1.0f));
+        }
+    }
+    // popped in the order of the file
+    std::vector<std::pair<size_t, glm::mat4>> stack = {};
+    for (size_t i = scene["nodes"].size(); i-- > 0;) {
+        stack.emplace_back(integer(scene["nodes"][i], SIZE_MAX), glm::mat4(1.0f));
+    }
+    // nodes form trees, a cycle would visit them forever
+    for (size_t visits = 0; ! stack.empty(); ++visits) {
+        auto [index, parent] = stack.back();
+        stack.pop_back();
+        const Json &node = gltf["nodes"][index];
+        if (node.is_null() || visits > gltf["nodes"].size()) {
+            return {{}, wrap(path + ": malformed node hierarchy")};
+        }
+        glm::mat4 model = parent * node_matrix(node);
+        if (! node["mesh"].is_null()) {
+            meshes.emplace_back(integer(node["mesh"], SIZE_MAX), model);
+        }
+        for (size_t i = node["children"].size(); i-- > 0;) {
+            stack.emplace_back(integer(node["children"][i], SIZE_MAX), model);
+        }
+    }
+
+    std::vector<GltfPrimitive> primitives = {};
+    size_t vertex_count                   = 0;
+    size_t index_count                    = 0;
+    for (auto [index, model] : meshes) {
+        const Json &mesh = gltf["meshes"][index];
+        if (mesh.is_null()) {
+            return {{}, wrap(path + ": missing mesh " + std::to_string(index))};
+        }
+        for (size_t i = 0; i < mesh["primitives"].size(); ++i) {
+            const Json &json = mesh["primitives"][i];
+            // points and lines have no place in a triangle list
+            if (integer(json["mode"], gltf_triangles) != gltf_triangles) {
+                continue;
+            }
+            const Json &attributes = json["attributes"];
+            if (attributes["POSITION"].is_null()) {
+                return {{}, wrap(path + ": primitive without positions")};
+            }
+
+            GltfPrimitive primitive = {};
+            primitive.model         = model;
+            primitive.normal_model  = glm::transpose(glm::inverse(glm::mat3(model)));
+            primitive.mirrored      = glm::determinant(glm::mat3(model)) < 0.0f;
+
+            Error accessor_error                  = {};
+            std::optional<GltfAccessor> positions = attribute(gltf, buffers, attributes, "POSITION", accessor_error);
+            primitive.normals                     = attribute(gltf, buffers, attributes, "NORMAL", accessor_error);
+            primitive.tex                         = attribute(gltf, buffers, attributes, "TEXCOORD_0", accessor_error);
+            primitive.colors                      = attribute(gltf, buffers, attributes, "COLOR_0", accessor_error);
+            primitive.indices                     = attribute(gltf, buffers, json, "indices", accessor_error);
+            if (accessor_error.has_value()) {
+                return {{}, wrap(path + ": " + *accessor_error)};
+            }
+            primitive.positions = *positions;
+            if (primitive.indices && (primitive.indices->components != 1 || primitive.indices->type == gltf_float)) {
+                return {{}, wrap(path + ": indices of unsupported type")};
+            }
+            primitive.triangles    = (primitive.indices ? primitive.indices->count : primitive.positions.count) / 3;
+            primitive.first_vertex = vertex_count;
+            primitive.first_index  = index_count;
+            vertex_count += primitive.positions.count;
+            index_count += 3 * primitive.triangles;
+            primitives.push_back(primitive);
+        }
+    }
+    if (vertex_count > UINT32_MAX) {
+        return {{}, wrap(path + ": too many vertices for 32 bits indices")};
+    }
+
+    std::vector<GltfRange> ranges = {};
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        for (size_t begin = 0; begin < primitives[i].positions.count; begin += gltf_range_size) {
+            ranges.push_back({i, false, begin, std::min(begin + gltf_range_size, primitives[i].positions.count)});
+        }
+        for (size_t begin = 0; begin < primitives[i].triangles; begin += gltf_range_size / 3) {
+            ranges.push_back({i, true, begin, std::min(begin + gltf_range_size / 3, primitives[i].triangles)});
+        }
+    }
+    m_stats.tasks   = ranges.size();
+    m_stats.corners = index_count;
+
+    MeshData mesh = {};
+    mesh.vertices.resize(vertex_count);
+    mesh.indices.resize(index_count);
+    std::vector<Error> errors(ranges.size());
+    m_pool.run(ranges.size(), [&](size_t i) {
+        const GltfRange &range         = ranges[i];
+        const GltfPrimitive &primitive = primitives[range.primitive];
+        if (! range.triangles) {
+            for (size_t v = range.begin; v < range.end; ++v) {
+                Vertex &vertex = mesh.vertices[primitive.first_vertex + v];
+                vertex.r       = glm::vec3(primitive.model * glm::vec4(glm::vec3(primitive.positions[v]), 1.0f));
+                vertex.color   = primitive.colors ? glm::vec3((*primitive.colors)[v]) : glm::vec3(1.0f);
+                vertex.t       = primitive.tex ? glm::vec2((*primitive.tex)[v]) : glm::vec2(0.0f);
+                if (primitive.normals) {
+                    vertex.normal = normalize_or_zero(primitive.normal_model * glm::vec3((*primitive.normals)[v]));
+                }
+            }
+            return;
+        }
+        for (size_t t = range.begin; t < range.end; ++t) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                // mirrored primitives swap the last two corners of their triangles
+                size_t source  = 3 * t + (primitive.mirrored && corner > 0 ? 3 - corner : corner);
+                uint32_t index = primitive.indices ? primitive.indices->index(source) : source;
+                if (index >= primitive.positions.count) {
+                    errors[i] = "index out of range";
+                    return;
+                }
+                mesh.indices[primitive.first_index + 3 * t + corner] = primitive.first_vertex + index;
+            }
+        }
+    });
+    for (const Error &range_error : errors) {
+        if (range_error.has_value()) {
+            return {{}, wrap(path + ": " + *range_error)};
+        }
+    }
+
+    // once every primitive's vertices and indices are in place
+    m_pool.run(primitives.size(), [&](size_t i) {
+        const GltfPrimitive &primitive = primitives[i];
+        if (primitive.normals) {
+            return;
+        }
+        for (size_t t = 0; t < primitive.triangles; ++t) {
+            const unsigned int *triangle = &mesh.indices[primitive.first_index + 3 * t];
+            Vertex &a = mesh.vertices[triangle[0]], &b = mesh.vertices[triangle[1]], &c = mesh.vertices[triangle[2]];
+            glm::vec3 normal = glm::cross(b.r - a.r, c.r - a.r);
+            a.normal += normal;
+            b.normal += normal;
+            c.normal += normal;
+        }
+        for (size_t v = 0; v < primitive.positions.count; ++v) {
+            Vertex &vertex = mesh.vertices[primitive.first_vertex + v];
+            vertex.normal  = normalize_or_zero(vertex.normal);
+        }
+    });
+    return {std::move(mesh), {}};
+}
+
+MeshLoader::MeshLoader(unsigned int threads) : m_pool(threads) {}
+
+std::pair<MeshData, Error> MeshLoader::load(const std::string &path) {
+    m_stats = {};
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return std::tolower(c);
+    });
+
+    std::pair<MeshData, Error> loaded = {};
+    if (extension == ".obj") {
+        loaded = load_obj(path);
+    } else if (extension == ".gltf" || extension == ".glb") {
+        loaded = load_gltf(path, extension == ".glb");
+    } else {
+        return {{}, wrap("unknown mesh format '" + extension + "' of " + path + ", expected .obj, .gltf or .glb")};
+    }
+    if (loaded.second.has_value()) {
+        return {{}, wrap(loaded.second)};
+    }
+    return loaded;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "error.hpp"
+#include "primitives.hpp"
+#include "vertex.hpp"
+#include "worker_pool.hpp"
+
+// bytes of OBJ text parsed by each task, at line boundaries
+constexpr static size_t obj_chunk_size = 1 << 20;
+
+// triangle list, ready for `VertexBuffer` and `IndexBuffer`
+struct MeshData {
+    Vertices vertices;
+    Indices indices;
+};
+
+// Loads meshes from Wavefront OBJ and glTF 2.0 files (.gltf with its buffers, or .glb) on the CPU. Files are mapped
+// into memory and converted by a pool of threads:
+//
+// - OBJ text is cut into chunks of `obj_chunk_size` at line boundaries and parsed one chunk per task. Once the
+//   positions, texture coordinates and normals of every chunk are gathered, each chunk deduplicates the corners of its
+//   faces into vertices, polygons are split in fans of triangles. Corners repeated across chunks keep a vertex per
+//   chunk; chunks do not depend on the threads, nor does the mesh.
+// - glTF buffers are already indexed, their attributes and indices are converted in ranges of `gltf_range_size`
+//   elements, every triangle primitive of the nodes of the default scene placed by its node's transform.
+//
+// Texture coordinates follow `Texture::from_file`, first image row at t = 0, and the colors of OBJ vertices the common
+// extension of three more values after the position. Missing colors are white, missing normals the average of those
+// of the faces around their position (OBJ) or vertex (glTF).
+class MeshLoader {
+  public:
+    // vertices or indices of a glTF primitive converted by each task
+    constexpr static size_t gltf_range_size = 1 << 16;
+
+    struct Stats {
+        // read from the file and the buffers it refers to
+        size_t bytes = 0;
+        // face corners read, before deduplication
+        size_t corners = 0;
+        size_t tasks   = 0;
+    };
+
+    explicit MeshLoader(unsigned int threads = std::thread::hardware_concurrency());
+
+    // the format follows the extension of `path`
+    std::pair<MeshData, Error> load(const std::string &path);
+
+    // of the last load
+    const Stats &stats() const { return m_stats; }
+    unsigned int threads() const { return m_pool.threads(); }
+
+    MeshLoader(const MeshLoader &other)            = delete;
+    MeshLoader &operator=(const MeshLoader &other) = delete;
+
+  private:
+    WorkerPool m_pool;
+    Stats m_stats = {};
+
+    std::pair<MeshData, Error> load_obj(const std::string &path);
+    std::pair<MeshData, Error> load_gltf(const std::string &path, bool binary);
+};
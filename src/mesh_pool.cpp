@@ -0,0 +1,37 @@
+#include "mesh_pool.hpp"
+
+static std::vector<PooledMesh> layout(const std::vector<std::pair<Vertices, Indices>> &meshes) {
+    std::vector<PooledMesh> pooled;
+    unsigned int first_index = 0;
+    int base_vertex          = 0;
+    for (const auto &[vertices, indices] : meshes) {
+        pooled.push_back({(unsigned int) indices.size(), first_index, base_vertex});
+        first_index += indices.size();
+        base_vertex += vertices.size();
+    }
+    return pooled;
+}
+
+static Vertices pack_vertices(const std::vector<std::pair<Vertices, Indices>> &meshes) {
+    Vertices packed;
+    for (const auto &[vertices, _] : meshes) {
+        packed.insert(packed.end(), vertices.begin(), vertices.end());
+    }
+    return packed;
+}
+
+static Indices pack_indices(const std::vector<std::pair<Vertices, Indices>> &meshes) {
+    Indices packed;
+    for (const auto &[_, indices] : meshes) {
+        packed.insert(packed.end(), indices.begin(), indices.end());
+    }
+    return packed;
+}
+
+MeshPool::MeshPool(const std::vector<std::pair<Vertices, Indices>> &meshes)
+    : m_meshes(layout(meshes)), m_vb(pack_vertices(meshes)), m_ib(pack_indices(meshes)), m_va(m_vb) {
+    // the index buffer is recorded by the vertex array, which must not capture the buffers created after it
+    m_va.bind();
+    m_ib.bind();
+    m_va.unbind();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "index_buffer.hpp"
+#include "primitives.hpp"
+#include "vertex_array.hpp"
+#include "vertex_buffer.hpp"
+
+// where a mesh landed in the shared buffers of its pool, in the terms of DrawElementsIndirectCommand
+struct PooledMesh {
+    unsigned int count;
+    unsigned int first_index;
+    int base_vertex;
+};
+
+// Packs static meshes into one vertex buffer and one index buffer behind a single vertex array, so that any of them is
+// drawn without rebinding anything.
+class MeshPool {
+  public:
+    MeshPool(const std::vector<std::pair<Vertices, Indices>> &meshes);
+
+    const PooledMesh &operator[](size_t i) const { return m_meshes[i]; }
+
+    const VertexArray &va() const { return m_va; }
+    const IndexBuffer &ib() const { return m_ib; }
+
+  private:
+    std::vector<PooledMesh> m_meshes;
+
+    VertexBuffer m_vb;
+    IndexBuffer m_ib;
+    VertexArray m_va;
+};
@@ -0,0 +1,101 @@
+#include "object_lights.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+// lanes tested at once, the lights are padded to a multiple of it
+constexpr static size_t lanes = 4;
+
+ObjectLights::ObjectLights(std::vector<Sphere> bounds, uint32_t max_lights, unsigned int threads)
+    : m_bounds(std::move(bounds)), m_max_lights(max_lights),
+      m_chunks((m_bounds.size() + chunk_size - 1) / chunk_size), m_ranges(m_bounds.size()), m_pool(threads) {}
+
+void ObjectLights::assign(const std::vector<Light> &lights, size_t count) {
+    count         = std::min(count, lights.size());
+    size_t padded = (count + lanes - 1) / lanes * lanes;
+    m_x.resize(padded);
+    m_y.resize(padded);
+    m_z.resize(padded);
+    m_radius.resize(padded);
+    for (size_t i = 0; i < padded; ++i) {
+        // padding lanes sit far away with a null radius, they never touch an object
+        glm::vec3 position = glm::vec3(unbounded_radius);
+        float radius       = 0.0f;
+        if (i < count) {
+            // directional lights are centered on the origin with an infinite radius
+            position = lights[i].position.w != 0.0f ? glm::vec3(lights[i].position) : glm::vec3(0.0f);
+            radius   = std::min(light_radius(lights[i]), unbounded_radius);
+        }
+        m_x[i]      = position.x;
+        m_y[i]      = position.y;
+        m_z[i]      = position.z;
+        m_radius[i] = radius;
+    }
+
+    m_pool.run(m_chunks.size(), [this](size_t chunk) { assign_chunk(chunk); });
+
+    size_t total = 0;
+    for (size_t chunk = 0; chunk < m_chunks.size(); ++chunk) {
+        size_t last = std::min((chunk + 1) * chunk_size, m_bounds.size());
+        for (size_t i = chunk * chunk_size; i < last; ++i) {
+            if (m_ranges[i].y != unculled) {
+                m_ranges[i].x += total;
+            }
+        }
+        total += m_chunks[chunk].size();
+    }
+    m_indices.resize(total);
+    auto output = m_indices.begin();
+    for (const std::vector<uint32_t> &indices : m_chunks) {
+        output = std::copy(indices.begin(), indices.end(), output);
+    }
+}
+
+void ObjectLights::assign_chunk(size_t chunk) {
+    std::vector<uint32_t> &indices = m_chunks[chunk];
+    indices.clear();
+
+    size_t last = std::min((chunk + 1) * chunk_size, m_bounds.size());
+    for (size_t object = chunk * chunk_size; object < last; ++object) {
+        const Sphere &bounds = m_bounds[object];
+        size_t offset        = indices.size();
+
+        // spheres overlap when their centers are closer than the sum of their radii
+#if defined(__SSE2__)
+        __m128 cx = _mm_set1_ps(bounds.center.x), cy = _mm_set1_ps(bounds.center.y), cz = _mm_set1_ps(bounds.center.z);
+        __m128 r = _mm_set1_ps(bounds.radius);
+        for (size_t i = 0; i < m_x.size(); i += lanes) {
+            __m128 dx    = _mm_sub_ps(_mm_loadu_ps(&m_x[i]), cx);
+            __m128 dy    = _mm_sub_ps(_mm_loadu_ps(&m_y[i]), cy);
+            __m128 dz    = _mm_sub_ps(_mm_loadu_ps(&m_z[i]), cz);
+            __m128 d2    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 reach = _mm_add_ps(_mm_loadu_ps(&m_radius[i]), r);
+
+            for (int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(reach, reach))); mask != 0; mask &= mask - 1) {
+                indices.push_back(i + __builtin_ctz(mask));
+            }
+            if (indices.size() - offset > m_max_lights) {
+                break;
+            }
+        }
+#else
+        for (size_t i = 0; i < m_x.size() && indices.size() - offset <= m_max_lights; ++i) {
+            glm::vec3 delta = glm::vec3(m_x[i], m_y[i], m_z[i]) - bounds.center;
+            float reach     = m_radius[i] + bounds.radius;
+            if (glm::dot(delta, delta) <= reach * reach) {
+                indices.push_back(i);
+            }
+        }
+#endif
+        if (indices.size() - offset > m_max_lights) {
+            indices.resize(offset);
+            m_ranges[object] = {0, unculled};
+        } else {
+            m_ranges[object] = {offset, indices.size() - offset};
+        }
+    }
+}
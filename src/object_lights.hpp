@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "light.hpp"
+#include "worker_pool.hpp"
+
+constexpr static unsigned int object_light_ranges_binding = 5;
+constexpr static unsigned int object_lights_binding       = 6;
+
+// world space bounding sphere
+struct Sphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// Per object light culling: every light is listed for the objects whose bounding sphere its attenuation sphere
+// intersects. Objects are identified by their index in `bounds`, which draws hand to the shaders as their instance
+// (gl_BaseInstance + gl_InstanceID). They are shared out in chunks to a pool of threads, each object being tested
+// against several lights at once.
+//
+// An object reached by more than `max_lights` lights keeps no list: its range counts `unculled` lights, more than any
+// other list the shader may pick instead. This bounds both the time and the memory taken by large scenes.
+class ObjectLights {
+  public:
+    constexpr static uint32_t unculled = ~0u;
+
+    ObjectLights(std::vector<Sphere> bounds, uint32_t max_lights = 64,
+        unsigned int threads = std::thread::hardware_concurrency());
+
+    // lists the first `count` lights for every object they reach
+    void assign(const std::vector<Light> &lights, size_t count);
+
+    size_t size() const { return m_bounds.size(); }
+    unsigned int threads() const { return m_pool.threads(); }
+
+    // (offset, count) in `indices` of the lights of each object
+    const std::vector<glm::uvec2> &ranges() const { return m_ranges; }
+    const std::vector<uint32_t> &indices() const { return m_indices; }
+
+    ObjectLights(const ObjectLights &other)            = delete;
+    ObjectLights &operator=(const ObjectLights &other) = delete;
+
+  private:
+    constexpr static size_t chunk_size = 256;
+
+    std::vector<Sphere> m_bounds;
+    uint32_t m_max_lights;
+
+    // lights of the current assignment, structure of arrays padded to a whole number of SIMD lanes
+    std::vector<float> m_x, m_y, m_z, m_radius;
+
+    // lights of the objects of each chunk, offsets relative to the chunk until they are laid end to end
+    std::vector<std::vector<uint32_t>> m_chunks;
+    std::vector<glm::uvec2> m_ranges;
+    std::vector<uint32_t> m_indices;
+
+    WorkerPool m_pool;
+
+    void assign_chunk(size_t chunk);
+};
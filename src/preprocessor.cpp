@@ -0,0 +1,81 @@
+#include "preprocessor.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static std::pair<std::string, Error> load(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::in);
+    if (! in) {
+        return {"", wrap("could not open " + path.string())};
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return {contents.str(), {}};
+}
+
+// file name of an `#include "file"` line, empty for any other line
+static std::pair<std::string, Error> included(const std::string &line) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+        return {"", {}};
+    }
+    size_t open  = line.find('"', start + 8);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos || close == open + 1) {
+        return {"", wrap("malformed include '" + line + "'")};
+    }
+    return {line.substr(open + 1, close - open - 1), {}};
+}
+
+static Error expand(const std::filesystem::path &path, const Defines &defines, Preprocessed &out) {
+    auto [source, error] = load(path);
+    if (error.has_value()) {
+        return wrap(error);
+    }
+    size_t index = out.files.size();
+    out.files.push_back(path);
+
+    std::istringstream in(source);
+    std::string line   = {};
+    unsigned int count = 0;
+    while (std::getline(in, line)) {
+        count += 1;
+
+        if (index == 0 && line.starts_with("#version")) {
+            out.source += line + "\n";
+            for (const auto &[name, value] : defines) {
+                out.source += "#define " + name + (value.empty() ? "" : " " + value) + "\n";
+            }
+            out.source += "#line " + std::to_string(count + 1) + " 0\n";
+            continue;
+        }
+
+        auto [name, include_error] = included(line);
+        if (include_error.has_value()) {
+            return wrap(path.string() + ":" + std::to_string(count) + ": " + include_error.value());
+        }
+        if (name.empty()) {
+            out.source += line + "\n";
+            continue;
+        }
+
+        std::filesystem::path file = path.parent_path() / name;
+        if (std::find(out.files.begin(), out.files.end(), file) == out.files.end()) {
+            out.source += "#line 1 " + std::to_string(out.files.size()) + "\n";
+            if (Error include = expand(file, {}, out); include.has_value()) {
+                return wrap(include);
+            }
+        }
+        out.source += "#line " + std::to_string(count + 1) + " " + std::to_string(index) + "\n";
+    }
+    return {};
+}
+
+std::pair<Preprocessed, Error> preprocess(const std::filesystem::path &path, const Defines &defines) {
+    Preprocessed out = {};
+    if (Error error = expand(path, defines, out); error.has_value()) {
+        return {{}, wrap(error)};
+    }
+    return {out, {}};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "error.hpp"
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// `#define name value` lines injected in a shader, in order
+using Defines = std::vector<std::pair<std::string, std::string>>;
+
+struct Preprocessed {
+    std::string source;
+    // the shader itself then every file it includes, in order of inclusion
+    std::vector<std::filesystem::path> files;
+};
+
+// Resolves `#include "file"` directives, relative to the including file, each file being included once at most, and
+// injects `defines` right after the `#version` line. `#line` directives keep compiler messages pointing at the original
+// lines, the source string number being the index of the file in `files`.
+std::pair<Preprocessed, Error> preprocess(const std::filesystem::path &path, const Defines &defines);
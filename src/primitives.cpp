@@ -2,6 +2,9 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 Vertices line(glm::vec3 origin, glm::vec3 direction, float length, glm::vec3 color) {
     auto left  = origin;
     auto right = origin + length * direction;
@@ -75,6 +78,26 @@ Vertices cube(glm::vec3 center, glm::vec3 a, glm::vec3 b, glm::vec3 c, float sca
            (right + (to_left * right) + top + (to_bottom * top) + front + (to_back * front));
 }
 
+glm::uvec2 unwrap_grid(const Vertices &vertices) {
+    unsigned int quads   = std::max(vertices.size() / 4, (size_t) 1);
+    unsigned int columns = std::ceil(std::sqrt((float) quads));
+    return {columns, (quads + columns - 1) / columns};
+}
+
+Vertices unwrap(const Vertices &vertices, unsigned int texels) {
+    glm::uvec2 grid = unwrap_grid(vertices);
+    // from the edge of the cell to the center of its border texels
+    float inset = 0.5f / std::max(texels, 1u);
+
+    Vertices unwrapped = vertices;
+    for (size_t i = 0; i < unwrapped.size(); ++i) {
+        unsigned int quad     = i / 4;
+        glm::vec2 cell        = {quad % grid.x, quad / grid.x};
+        unwrapped[i].lightmap = (cell + inset + (1.0f - 2.0f * inset) * full[i % 4]) / glm::vec2(grid);
+    }
+    return unwrapped;
+}
+
 Indices line_indices(const Vertices &vertices) {
     Indices indices;
     indices.reserve(vertices.size() % 2 ? (vertices.size() > 0 ? vertices.size() - 1 : 0) : vertices.size());
@@ -95,3 +118,19 @@ Indices quad_indices(const Vertices &vertices) {
     }
     return indices;
 }
+
+Indices outward_indices(const Vertices &vertices) {
+    glm::vec3 center = glm::vec3(0.0f);
+    for (const Vertex &vertex : vertices) {
+        center += vertex.r / (float) vertices.size();
+    }
+
+    Indices indices = quad_indices(vertices);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        glm::vec3 a = vertices[indices[i]].r, b = vertices[indices[i + 1]].r, c = vertices[indices[i + 2]].r;
+        if (glm::dot(glm::cross(b - a, c - a), a + b + c - 3.0f * center) < 0.0f) {
+            std::swap(indices[i + 1], indices[i + 2]);
+        }
+    }
+    return indices;
+}
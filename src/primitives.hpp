@@ -2,8 +2,12 @@
 
 #include <vector>
 
+#include <glad/glad.h>
+
 #include "vertex.hpp"
 
+enum Primitive { LINES = GL_LINES, TRIANGLES = GL_TRIANGLES };
+
 using TexCoord = glm::vec2;
 using Color    = glm::vec3;
 Vertices line(glm::vec3 origin, glm::vec3 direction, float length, Color color = {0.0f, 0.0f, 0.0f});
@@ -23,6 +27,16 @@ Vertices cube(
 Vertices cube(glm::vec3 center, glm::vec3 a, glm::vec3 b, glm::vec3 c, float scale, const std::array<Color, 4> &colors,
     const std::array<TexCoord, 4> &tex_coords);
 
+// cells of the lightmap tile of a mesh made of quads, columns and rows, as close to a square as they get
+glm::uvec2 unwrap_grid(const Vertices &vertices);
+// lays every quad of `vertices` (four consecutive vertices, as drawn by `quad_indices`) out in a cell of its own of
+// the mesh's lightmap tile, [0, 1]² in `Vertex::lightmap`. Cells are `texels` texels a side and the quad corners fall
+// on the centers of their corner texels, so that bilinear filtering never reads a neighbouring cell.
+Vertices unwrap(const Vertices &vertices, unsigned int texels);
+
 using Indices = std::vector<unsigned int>;
 Indices line_indices(const Vertices &vertices);
 Indices quad_indices(const Vertices &vertices);
+// like `quad_indices`, every triangle of a convex mesh wound counterclockwise seen from outside, for face culling:
+// `cube` copies its right, top and front faces to the opposite sides without mirroring them
+Indices outward_indices(const Vertices &vertices);
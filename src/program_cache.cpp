@@ -0,0 +1,120 @@
+#include "program_cache.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+bool ProgramCache::m_enabled                    = false;
+std::filesystem::path ProgramCache::m_directory = {};
+std::string ProgramCache::m_driver              = {};
+ProgramCache::Stats ProgramCache::m_stats       = {};
+
+static std::string gl_string(GLenum name) {
+    const GLubyte *str = glGetString(name);
+    return str != nullptr ? reinterpret_cast<const char *>(str) : "";
+}
+
+void ProgramCache::open(const std::filesystem::path &directory) {
+    int formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    std::error_code error = {};
+    std::filesystem::create_directories(directory, error);
+    if (formats == 0 || error) {
+        m_enabled = false;
+        return;
+    }
+
+    m_enabled   = true;
+    m_directory = directory;
+    m_driver    = {};
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION}) {
+        m_driver += gl_string(name) + "\n";
+    }
+}
+
+// 64 bits FNV-1a, stable across runs and platforms unlike std::hash
+static uint64_t fnv1a(uint64_t hash, const std::string &str) {
+    for (unsigned char c : str) {
+        hash = (hash ^ c) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string ProgramCache::key(const std::vector<std::string> &sources) {
+    // sizes keep the boundaries between strings part of the hash
+    uint64_t hash = fnv1a(0xcbf29ce484222325ull, m_driver);
+    for (const std::string &source : sources) {
+        hash = fnv1a(fnv1a(hash, std::to_string(source.size())), source);
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
+unsigned int ProgramCache::load(const std::string &key) {
+    if (! m_enabled) {
+        return 0;
+    }
+
+    std::filesystem::path path = m_directory / (key + ".bin");
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    GLenum format = 0;
+    if (! in || ! in.read(reinterpret_cast<char *>(&format), sizeof(format))) {
+        m_stats.misses += 1;
+        return 0;
+    }
+    std::vector<char> binary = {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    in.close();
+
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), binary.size());
+
+    // a driver update, or anything else invalidating the binary, shows as a failed link
+    int result = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        glDeleteProgram(program);
+        std::error_code error = {};
+        std::filesystem::remove(path, error);
+        m_stats.stale += 1;
+        m_stats.misses += 1;
+        return 0;
+    }
+
+    m_stats.hits += 1;
+    return program;
+}
+
+void ProgramCache::store(const std::string &key, unsigned int program) {
+    if (! m_enabled) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length == 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    // written aside then renamed, a concurrent run never reads a partial entry
+    std::filesystem::path path = m_directory / (key + ".bin");
+    std::filesystem::path tmp  = m_directory / (key + ".tmp");
+    std::ofstream out(tmp, std::ios::out | std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&format), sizeof(format));
+    out.write(binary.data(), length);
+    out.close();
+
+    std::error_code error = {};
+    if (out) {
+        std::filesystem::rename(tmp, path, error);
+    } else {
+        std::filesystem::remove(tmp, error);
+    }
+}
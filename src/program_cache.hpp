@@ -0,0 +1,37 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Linked program binaries kept on disk, keyed by the shader sources and the driver identity. The cache is best effort:
+// an entry that cannot be read, written or that the driver rejects only costs a regular compilation.
+class ProgramCache {
+  public:
+    struct Stats {
+        unsigned int hits   = 0;
+        unsigned int misses = 0;
+        // entries the driver refused to load, removed on the spot
+        unsigned int stale = 0;
+    };
+
+    // enables the cache in `directory` if the driver supports at least one binary format, needs a current context
+    static void open(const std::filesystem::path &directory);
+    static bool enabled() { return m_enabled; }
+
+    // identifies the program linked from `sources` on the current driver
+    static std::string key(const std::vector<std::string> &sources);
+    // program linked from the binary stored under `key`, 0 if there is none usable
+    static unsigned int load(const std::string &key);
+    // `program` must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    static void store(const std::string &key, unsigned int program);
+
+    static const Stats &stats() { return m_stats; }
+
+  private:
+    static bool m_enabled;
+    static std::filesystem::path m_directory;
+    // vendor, renderer and version strings, part of every key
+    static std::string m_driver;
+    static Stats m_stats;
+};
@@ -0,0 +1,169 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+constexpr static unsigned int program_bits  = 8;
+constexpr static unsigned int material_bits = 8;
+constexpr static unsigned int mesh_bits     = 16;
+
+constexpr static unsigned int mesh_shift     = 32;
+constexpr static unsigned int material_shift = mesh_shift + mesh_bits;
+constexpr static unsigned int program_shift  = material_shift + material_bits;
+
+static unsigned int field(uint64_t key, unsigned int shift, unsigned int bits) {
+    return (key >> shift) & ((uint64_t(1) << bits) - 1);
+}
+
+// non negative floats order like their bit patterns
+static uint64_t sort_key(unsigned int program, unsigned int material, unsigned int mesh, float depth) {
+    uint32_t depth_bits = 0;
+    depth               = std::max(depth, 0.0f);
+    std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    return (uint64_t(program) << program_shift) | (uint64_t(material) << material_shift) |
+           (uint64_t(mesh) << mesh_shift) | depth_bits;
+}
+
+template <typename T> static unsigned int switches(const std::vector<T> &commands, unsigned int shift,
+    unsigned int bits) {
+    unsigned int count = 0;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        if (i == 0 || field(commands[i].key, shift, bits) != field(commands[i - 1].key, shift, bits)) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+// least significant digit first, 8 bits per pass; passes over a digit shared by every key are skipped
+template <typename T> static void radix_sort(std::vector<T> &commands, std::vector<T> &scratch) {
+    scratch.resize(commands.size());
+    for (unsigned int shift = 0; shift < 64 && ! commands.empty(); shift += 8) {
+        std::array<size_t, 256> offsets = {};
+        for (const auto &command : commands) {
+            offsets[(command.key >> shift) & 0xff] += 1;
+        }
+        if (offsets[(commands[0].key >> shift) & 0xff] == commands.size()) {
+            continue;
+        }
+
+        size_t sum = 0;
+        for (auto &offset : offsets) {
+            sum += std::exchange(offset, sum);
+        }
+        for (const auto &command : commands) {
+            scratch[offsets[(command.key >> shift) & 0xff]++] = command;
+        }
+        std::swap(commands, scratch);
+    }
+}
+
+unsigned int RenderQueue::Stats::saved() const {
+    return (unsorted_program_switches + unsorted_material_switches + unsorted_mesh_switches) -
+           (program_switches + material_switches + mesh_switches);
+}
+
+RenderQueue::Stats &RenderQueue::Stats::operator+=(const Stats &other) {
+    draws += other.draws;
+
+    program_switches += other.program_switches;
+    material_switches += other.material_switches;
+    mesh_switches += other.mesh_switches;
+
+    unsorted_program_switches += other.unsorted_program_switches;
+    unsorted_material_switches += other.unsorted_material_switches;
+    unsorted_mesh_switches += other.unsorted_mesh_switches;
+    return *this;
+}
+
+std::pair<unsigned int, Error> RenderQueue::add_material(Material &&material) {
+    if (m_materials.size() == (1u << material_bits)) {
+        return {0, wrap("too many materials")};
+    }
+
+    auto program = std::find(m_programs.begin(), m_programs.end(), material.shader);
+    if (program == m_programs.end()) {
+        if (m_programs.size() == (1u << program_bits)) {
+            return {0, wrap("too many programs")};
+        }
+        program = m_programs.insert(m_programs.end(), material.shader);
+    }
+
+    m_material_programs.push_back(program - m_programs.begin());
+    m_materials.push_back(std::move(material));
+    return {(unsigned int) m_materials.size() - 1, {}};
+}
+
+std::pair<unsigned int, Error> RenderQueue::add_mesh(const Mesh &mesh) {
+    if (m_meshes.size() == (1u << mesh_bits)) {
+        return {0, wrap("too many meshes")};
+    }
+    m_meshes.push_back(mesh);
+    return {(unsigned int) m_meshes.size() - 1, {}};
+}
+
+void RenderQueue::push(unsigned int material, unsigned int mesh, float depth, const Object &object) {
+    m_commands.push_back({sort_key(m_material_programs[material], material, mesh, depth), (uint32_t) m_objects.size()});
+    m_objects.push_back(object);
+}
+
+RenderQueue::Stats RenderQueue::submit() {
+    Stats stats = {};
+    stats.draws = m_commands.size();
+
+    stats.unsorted_program_switches  = switches(m_commands, program_shift, program_bits);
+    stats.unsorted_material_switches = switches(m_commands, material_shift, material_bits);
+    stats.unsorted_mesh_switches     = switches(m_commands, mesh_shift, mesh_bits);
+
+    radix_sort(m_commands, m_scratch);
+
+    const Material *material = nullptr;
+    const Mesh *mesh         = nullptr;
+    Shader *program          = nullptr;
+    for (const auto &command : m_commands) {
+        const Material *next_material = &m_materials[field(command.key, material_shift, material_bits)];
+        const Mesh *next_mesh         = &m_meshes[field(command.key, mesh_shift, mesh_bits)];
+
+        if (next_material->shader != program) {
+            program = next_material->shader;
+            program->bind();
+            stats.program_switches += 1;
+        }
+
+        if (next_material != material) {
+            material = next_material;
+            for (const Texture &texture : material->textures) {
+                texture.bind();
+            }
+            if (material->bind) {
+                material->bind(*program);
+            }
+            stats.material_switches += 1;
+        }
+
+        if (next_mesh != mesh) {
+            mesh = next_mesh;
+            mesh->va->bind();
+            mesh->ib->bind();
+            stats.mesh_switches += 1;
+        }
+
+        const Object &object = m_objects[command.object];
+        if (material->object) {
+            material->object(*program, object);
+        }
+
+        if (object.instances == 1 && object.base_instance == 0) {
+            glDrawElements(mesh->primitive, mesh->ib->count(), GL_UNSIGNED_INT, nullptr);
+        } else {
+            glDrawElementsInstancedBaseInstance(
+                mesh->primitive, mesh->ib->count(), GL_UNSIGNED_INT, nullptr, object.instances, object.base_instance);
+        }
+    }
+
+    m_commands.clear();
+    m_objects.clear();
+    return stats;
+}
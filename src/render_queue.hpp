@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "error.hpp"
+#include "index_buffer.hpp"
+#include "primitives.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "vertex_array.hpp"
+
+// per draw payload, handed back to the material when the command is submitted
+struct Object {
+    glm::mat4 model {1.0f};
+    glm::vec4 color {0.0f, 0.0f, 0.0f, 0.0f};
+    unsigned int instances = 1;
+    // first instance drawn, how vertex shaders find the object in per object storage (gl_BaseInstance)
+    unsigned int base_instance = 0;
+};
+
+struct Material {
+    Shader *shader;
+    std::vector<Texture> textures;
+
+    // uniforms shared by every object of the material, written once per material switch
+    std::function<void(Shader &)> bind;
+    // uniforms of a single object, written before each of its draws
+    std::function<void(Shader &, const Object &)> object;
+};
+
+struct Mesh {
+    Primitive primitive;
+    const VertexArray *va;
+    const IndexBuffer *ib;
+};
+
+// Draws are recorded as a 64 bits sort key and an index into the recorded objects, then radix sorted and submitted in
+// one go. The key orders by program, material (texture set), mesh (vertex array) and finally depth, so that each state
+// is bound once per group instead of once per object.
+class RenderQueue {
+  public:
+    struct Stats {
+        unsigned int draws = 0;
+
+        unsigned int program_switches  = 0;
+        unsigned int material_switches = 0;
+        unsigned int mesh_switches     = 0;
+
+        // switches the same draws would have cost in recording order
+        unsigned int unsorted_program_switches  = 0;
+        unsigned int unsorted_material_switches = 0;
+        unsigned int unsorted_mesh_switches     = 0;
+
+        unsigned int saved() const;
+        Stats &operator+=(const Stats &other);
+    };
+
+    std::pair<unsigned int, Error> add_material(Material &&material);
+    std::pair<unsigned int, Error> add_mesh(const Mesh &mesh);
+
+    void push(unsigned int material, unsigned int mesh, float depth, const Object &object);
+    Stats submit();
+
+  private:
+    struct Command {
+        uint64_t key;
+        uint32_t object;
+    };
+
+    std::vector<Shader *> m_programs;
+    std::vector<Material> m_materials;
+    std::vector<unsigned int> m_material_programs;
+    std::vector<Mesh> m_meshes;
+
+    std::vector<Command> m_commands;
+    std::vector<Command> m_scratch;
+    std::vector<Object> m_objects;
+};
@@ -0,0 +1,100 @@
+#include "ring_buffer.hpp"
+#include "state_cache.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <utility>
+
+RingBuffer::Stats &RingBuffer::Stats::operator+=(const Stats &other) {
+    waits += other.waits;
+    wait_ms += other.wait_ms;
+    max_wait_ms = std::max(max_wait_ms, other.max_wait_ms);
+    return *this;
+}
+
+static size_t align(size_t offset, size_t alignment) { return (offset + alignment - 1) / alignment * alignment; }
+
+RingBuffer::RingBuffer(size_t region_size) {
+    int uniform_alignment = 0;
+    int storage_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+    m_alignment   = std::max({uniform_alignment, storage_alignment, 1});
+    m_region_size = align(region_size, m_alignment);
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_ID);
+    StateCache::bind_buffer(GL_COPY_WRITE_BUFFER, m_ID);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, frames * m_region_size, nullptr, flags);
+    m_data = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frames * m_region_size, flags));
+}
+
+RingBuffer::~RingBuffer() {
+    for (void *fence : m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    if (m_data != nullptr) {
+        StateCache::bind_buffer(GL_COPY_WRITE_BUFFER, m_ID);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+Error RingBuffer::status() const {
+    if (m_data == nullptr) {
+        return wrap("could not map the " + std::to_string(frames * m_region_size) + " bytes of the ring buffer");
+    }
+    return {};
+}
+
+void RingBuffer::begin() {
+    m_offset = 0;
+
+    GLsync fence = static_cast<GLsync>(std::exchange(m_fences[m_frame], nullptr));
+    if (fence == nullptr) {
+        return;
+    }
+
+    // polls first so that a signaled fence is not counted as a wait
+    if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_stats += {1, ms, ms};
+    }
+    glDeleteSync(fence);
+}
+
+Error RingBuffer::push(unsigned int target, unsigned int binding, const void *data, size_t size) {
+    auto [destination, error] = allocate(target, binding, size);
+    if (error.has_value()) {
+        return wrap(error);
+    }
+    std::memcpy(destination, data, size);
+    return {};
+}
+
+std::pair<void *, Error> RingBuffer::allocate(unsigned int target, unsigned int binding, size_t size) {
+    if (m_offset + size > m_region_size) {
+        return {nullptr, clean("ring buffer region of " + std::to_string(m_region_size) + " bytes is full")};
+    }
+
+    size_t offset = m_frame * m_region_size + m_offset;
+    StateCache::bind_buffer_range(target, binding, m_ID, offset, size);
+    m_offset = align(m_offset + size, m_alignment);
+    return {m_data + offset, {}};
+}
+
+RingBuffer::Stats RingBuffer::end() {
+    m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_frame           = (m_frame + 1) % frames;
+    return std::exchange(m_stats, {});
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "error.hpp"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// Persistently mapped buffer streaming per-frame data, split into one region per frame in flight. Writes land directly
+// in mapped memory; a fence placed at the end of a frame guards its region until the GPU is done reading it.
+class RingBuffer {
+  public:
+    constexpr static unsigned int frames = 3;
+
+    struct Stats {
+        // fences still unsignaled when their region came back, i.e. the CPU got `frames` frames ahead of the GPU
+        unsigned int waits = 0;
+        double wait_ms     = 0.0;
+        double max_wait_ms = 0.0;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+    RingBuffer(size_t region_size);
+    ~RingBuffer();
+
+    // the buffer could not be mapped, nothing can be written to it
+    Error status() const;
+
+    // waits for the region of the starting frame to be released by the GPU
+    void begin();
+    // copies `data` into the current region and binds the copy to the indexed binding point `binding` of `target`
+    Error push(unsigned int target, unsigned int binding, const void *data, size_t size);
+    // binds `size` bytes of the current region like `push` and returns them to be written in place
+    std::pair<void *, Error> allocate(unsigned int target, unsigned int binding, size_t size);
+    // fences the current region and moves to the next one, returns the fence wait of the frame
+    Stats end();
+
+  private:
+    unsigned int m_ID;
+    char *m_data;
+    size_t m_region_size;
+    size_t m_alignment;
+
+    unsigned int m_frame                = 0;
+    size_t m_offset                     = 0;
+    std::array<void *, frames> m_fences = {};
+    Stats m_stats                       = {};
+};
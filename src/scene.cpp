@@ -0,0 +1,90 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+constexpr static float spacing = 2.0f;
+
+static void bound(Scene &scene) {
+    glm::vec3 lo = scene.cube_positions.empty() ? glm::vec3(0.0f) : scene.cube_positions.front();
+    glm::vec3 hi = lo;
+    for (const glm::vec3 &position : scene.cube_positions) {
+        lo = glm::min(lo, position);
+        hi = glm::max(hi, position);
+    }
+    scene.center = 0.5f * (lo + hi);
+    scene.radius = 0.5f * glm::length(hi - lo) + 1.0f;
+}
+
+Scene tutorial_scene() {
+    glm::vec3 white = glm::vec3(1.0f);
+    Scene scene     = {
+        {
+            glm::vec3(0.0f, 0.0f, 0.0f),
+            glm::vec3(2.0f, 5.0f, -15.0f),
+            glm::vec3(-1.5f, -2.2f, -2.5f),
+            glm::vec3(-3.8f, -2.0f, -12.3f),
+            glm::vec3(2.4f, -0.4f, -3.5f),
+            glm::vec3(-1.7f, 3.0f, -7.5f),
+            glm::vec3(1.3f, -2.0f, -2.5f),
+            glm::vec3(1.5f, 2.0f, -2.5f),
+            glm::vec3(1.5f, 0.2f, -1.5f),
+            glm::vec3(-1.3f, 1.0f, -1.5f),
+        },
+        {
+            {{0.7f, 0.2f, 2.0f}, white},
+            {{2.3f, -3.3f, -4.0f}, glm::vec3(1.0f, 0.0f, 0.0f)},
+            {{-4.0f, 2.0f, -12.0f}, glm::vec3(0.0f, 1.0f, 0.0f)},
+            {{0.0f, 0.0f, -3.0f}, glm::vec3(0.0f, 0.0f, 1.0f)},
+        },
+    };
+    bound(scene);
+    return scene;
+}
+
+// std::mt19937 output is specified, the standard distributions are not: floats in [0, 1) are built by hand
+static float uniform(std::mt19937 &rng) { return (rng() >> 8) * (1.0f / 16777216.0f); }
+
+static glm::vec3 uniform3(std::mt19937 &rng) {
+    float x = uniform(rng);
+    float y = uniform(rng);
+    return {x, y, uniform(rng)};
+}
+
+Scene generate_scene(Layout layout, size_t cubes, size_t lights, unsigned int seed) {
+    if (layout == Layout::TUTORIAL) {
+        return tutorial_scene();
+    }
+
+    std::mt19937 rng = std::mt19937(seed);
+
+    // smallest cubic grid holding every cube, centered on the origin
+    size_t side      = std::max<size_t>(1, std::ceil(std::cbrt((double) cubes)));
+    glm::vec3 corner = -0.5f * spacing * glm::vec3(side - 1);
+    glm::vec3 extent = spacing * glm::vec3(side - 1);
+
+    Scene scene = {};
+    scene.cube_positions.reserve(cubes);
+    for (size_t i = 0; i < cubes; ++i) {
+        if (layout == Layout::GRID) {
+            glm::vec3 cell = glm::vec3(i % side, (i / side) % side, i / (side * side));
+            scene.cube_positions.push_back(corner + spacing * cell);
+        } else {
+            scene.cube_positions.push_back(corner + extent * uniform3(rng));
+        }
+    }
+
+    // learnopengl's attenuation for a range of 13 rather than 50: the lights fade out 4 cubes away, however large the
+    // scene
+    scene.attenuation = {0.35f, 0.44f};
+    scene.lights.reserve(lights);
+    for (size_t i = 0; i < lights; ++i) {
+        glm::vec3 position = corner + extent * uniform3(rng);
+        glm::vec3 color    = uniform3(rng);
+        scene.lights.push_back({position, color / std::max({color.r, color.g, color.b, 1e-3f})});
+    }
+
+    bound(scene);
+    return scene;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+enum class Layout { TUTORIAL, GRID, RANDOM };
+
+struct Scene {
+    std::vector<glm::vec3> cube_positions = {};
+    // positions and colors of the point lights
+    std::vector<std::pair<glm::vec3, glm::vec3>> lights = {};
+    // linear and quadratic attenuation of the point lights
+    glm::vec2 attenuation = {0.09f, 0.032f};
+
+    // bounding sphere of the cubes
+    glm::vec3 center = {0.0f, 0.0f, 0.0f};
+    float radius     = 0.0f;
+};
+
+// learnopengl's ten cubes and four lights
+Scene tutorial_scene();
+// `cubes` cubes on a regular grid or spread uniformly over the same volume, and `lights` lights of random colors
+// spread over it as well, each reaching a few cubes around it. The same arguments give the same scene on every
+// platform.
+Scene generate_scene(Layout layout, size_t cubes, size_t lights, unsigned int seed);
@@ -1,30 +1,33 @@
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <utility>
 
 #include <glad/glad.h>
 
 #include <glm/gtc/type_ptr.hpp>
 
 #include "error.hpp"
+#include "program_cache.hpp"
 #include "shader.hpp"
+#include "state_cache.hpp"
 
-static std::pair<std::string, Error> load_shader(const std::string &filepath) {
-    std::ifstream in(filepath, std::ios::in);
-    if (! in) {
-        return {"", wrap("could not open " + filepath)};
-    }
-    std::ostringstream contents;
-    contents << in.rdbuf();
-    in.close();
-    return {contents.str(), {}};
-}
+// not part of the glad profile, loaded by `Shader::parallel_compile`
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (*PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+static bool parallel = false;
 
-static std::pair<unsigned int, Error> compile_shader(unsigned int type, const std::string &source) {
+static unsigned int submit_shader(unsigned int type, const std::string &source) {
     unsigned int id = glCreateShader(type);
     const char *src = source.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+    return id;
+}
 
+// first query of the compilation, waits for it to end
+static Error check_shader(unsigned int id) {
     int result = 0;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -33,120 +36,61 @@ static std::pair<unsigned int, Error> compile_shader(unsigned int type, const st
 
         std::vector<char> msg(length);
         glGetShaderInfoLog(id, length, &length, msg.data());
-
-        glDeleteShader(id);
-        return {0, wrap(clean(msg.data()))};
+        return wrap(clean(msg.data()));
     }
-
-    return {id, {}};
+    return {};
 }
 
-static std::pair<unsigned int, Error> create_shader(const std::string &vertex, const std::string &fragment) {
-    auto [vertex_shader, vertex_error] = compile_shader(GL_VERTEX_SHADER, vertex);
-    if (vertex_error.has_value()) {
-        return {0, wrap(vertex_error)};
-    }
-    auto [fragment_shader, fragment_error] = compile_shader(GL_FRAGMENT_SHADER, fragment);
-    if (fragment_error.has_value()) {
-        return {0, wrap(fragment_error)};
-    }
-
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
-
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-
+static Error check_program(unsigned int program, unsigned int status) {
     int result = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    glGetProgramiv(program, status, &result);
     if (result == GL_FALSE) {
         int length = 0;
         glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
 
         std::vector<char> msg(length);
         glGetProgramInfoLog(program, length, &length, msg.data());
-
-        glDeleteProgram(program);
-        return {0, wrap(clean(msg.data()))};
+        return wrap(clean(msg.data()));
     }
-
-    glValidateProgram(program);
-
-    result = 0;
-    glGetProgramiv(program, GL_VALIDATE_STATUS, &result);
-    if (result == GL_FALSE) {
-        int length = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-
-        std::vector<char> msg(length);
-        glGetProgramInfoLog(program, length, &length, msg.data());
-
-        glDeleteProgram(program);
-        return {0, wrap(clean(msg.data()))};
-    }
-
-    return {program, {}};
+    return {};
 }
 
-Shader::Shader(Shader &&other) : m_ID(other.m_ID), m_location_cache(other.m_location_cache) { other.m_ID = 0; }
+Shader::Shader(Shader &&other)
+    : m_ID(other.m_ID), m_sources(std::move(other.m_sources)), m_uniforms(std::move(other.m_uniforms)),
+      m_blocks(std::move(other.m_blocks)), m_values(std::move(other.m_values)) {
+    other.m_ID = 0;
+}
 
 Shader &Shader::operator=(Shader &&other) {
     if (&other != this) {
+        // the program being replaced is released, hot reloads would leak it otherwise
+        if (m_ID) {
+            StateCache::forget_program(m_ID);
+            glDeleteProgram(m_ID);
+        }
         m_ID       = other.m_ID;
         other.m_ID = 0;
 
-        m_location_cache = other.m_location_cache;
+        m_sources  = std::move(other.m_sources);
+        m_uniforms = std::move(other.m_uniforms);
+        m_blocks   = std::move(other.m_blocks);
+        m_values   = std::move(other.m_values);
     }
     return *this;
 }
 
 Shader::~Shader() {
     if (m_ID) {
+        StateCache::forget_program(m_ID);
         glDeleteProgram(m_ID);
     }
 }
 
-void Shader::bind() const { glUseProgram(m_ID); }
-void Shader::unbind() const { glUseProgram(0); }
-
-template <typename T> std::vector<T> &insert(std::vector<T> &v, std::vector<T> &&other) {
-    v.insert(v.end(), other.begin(), other.end());
-    return v;
-}
-
-Error Shader::set_lights(const std::string &name, const std::vector<Light> &lights) {
-    std::vector<Uniform> uniforms;
-    for (size_t i = 0; i < lights.size(); ++i) {
-        std::ostringstream oss;
-        oss << name << "[" << i << "]"
-            << ".";
-
-        const Light &light = lights[i];
-        uniforms           = insert(uniforms,
-            {
-                {oss.str() + "position", light.position},
-
-                {oss.str() + "is_directional", light.is_directional},
-                {oss.str() + "direction", light.direction},
-                {oss.str() + "cut_off", light.cut_off},
-                {oss.str() + "outer_cut_off", light.outer_cut_off},
-
-                {oss.str() + "ambient", light.ambient},
-                {oss.str() + "diffuse", light.diffuse},
-                {oss.str() + "specular", light.specular},
-
-                {oss.str() + "constant", light.constant},
-                {oss.str() + "linear", light.linear},
-                {oss.str() + "quadratic", light.quadratic},
-            });
-    }
-    return set_uniforms(uniforms);
-}
+void Shader::bind() const { StateCache::use_program(m_ID); }
+void Shader::unbind() const { StateCache::use_program(0); }
 
 Error Shader::set_uniforms(const std::vector<Uniform> &uniforms) {
-    for (auto [name, value] : uniforms) {
+    for (const auto &[name, value] : uniforms) {
         Error error = {};
         if (auto valueptr = std::get_if<bool>(&value)) {
             error = set_uniform(name, *valueptr);
@@ -178,47 +122,47 @@ Error Shader::set_uniforms(const std::vector<Uniform> &uniforms) {
 }
 
 Error Shader::set_uniform(const std::string &name, bool value) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, value);
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniform1i(location, value);
+    set(UniformHandle<bool> {location}, value);
     return {};
 }
 
 Error Shader::set_uniform(const std::string &name, int value) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, value);
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniform1i(location, value);
+    set(UniformHandle<int> {location}, value);
     return {};
 }
 
 Error Shader::set_uniform(const std::string &name, float value) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, value);
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniform1f(location, value);
+    set(UniformHandle<float> {location}, value);
     return {};
 }
 
 Error Shader::set_uniform(const std::string &name, float r, float g, float b) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, f3 {r, g, b});
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniform3f(location, r, g, b);
+    set(UniformHandle<f3> {location}, {r, g, b});
     return {};
 }
 
 Error Shader::set_uniform(const std::string &name, float r, float g, float b, float a) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, f4 {r, g, b, a});
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniform4f(location, r, g, b, a);
+    set(UniformHandle<f4> {location}, {r, g, b, a});
     return {};
 }
 
@@ -231,39 +175,364 @@ Error Shader::set_uniform(const std::string &name, const glm::vec4 &vector) {
 }
 
 Error Shader::set_uniform(const std::string &name, const glm::mat4 &matrix) {
-    auto [location, error] = get_uniform_location(name);
+    auto [location, error] = get_uniform_location(name, matrix);
     if (error.has_value()) {
         return wrap(error);
     }
-    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+    set(UniformHandle<glm::mat4> {location}, matrix);
     return {};
 }
 
-std::pair<Shader, Error> Shader::from_files(const std::string &vertex, const std::string &fragment) {
-    auto [vertex_shader, vertex_error] = load_shader(vertex);
-    if (vertex_error.has_value()) {
-        return {Shader(0), wrap(vertex_error)};
+void Shader::set(UniformHandle<bool> handle, bool value) const { set(UniformHandle<int> {handle.location}, value); }
+
+void Shader::set(UniformHandle<int> handle, int value) const {
+    if (update(handle.location, &value, sizeof(value))) {
+        glUniform1i(handle.location, value);
     }
-    auto [fragment_shader, fragment_error] = load_shader(fragment);
-    if (fragment_error.has_value()) {
-        return {Shader(0), wrap(fragment_error)};
+}
+
+void Shader::set(UniformHandle<float> handle, float value) const {
+    if (update(handle.location, &value, sizeof(value))) {
+        glUniform1f(handle.location, value);
     }
-    auto [shaderID, error] = create_shader(vertex_shader, fragment_shader);
-    if (error.has_value()) {
-        return {Shader(0), wrap(error)};
+}
+
+void Shader::set(UniformHandle<f3> handle, const f3 &value) const {
+    auto [x, y, z] = value;
+    set(UniformHandle<glm::vec3> {handle.location}, glm::vec3(x, y, z));
+}
+
+void Shader::set(UniformHandle<f4> handle, const f4 &value) const {
+    auto [x, y, z, w] = value;
+    set(UniformHandle<glm::vec4> {handle.location}, glm::vec4(x, y, z, w));
+}
+
+void Shader::set(UniformHandle<glm::vec3> handle, const glm::vec3 &vector) const {
+    if (update(handle.location, glm::value_ptr(vector), sizeof(vector))) {
+        glUniform3fv(handle.location, 1, glm::value_ptr(vector));
+    }
+}
+
+void Shader::set(UniformHandle<glm::vec4> handle, const glm::vec4 &vector) const {
+    if (update(handle.location, glm::value_ptr(vector), sizeof(vector))) {
+        glUniform4fv(handle.location, 1, glm::value_ptr(vector));
+    }
+}
+
+void Shader::set(UniformHandle<glm::mat4> handle, const glm::mat4 &matrix) const {
+    if (update(handle.location, glm::value_ptr(matrix), sizeof(matrix))) {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(matrix));
+    }
+}
+
+StateCache::Counter Shader::uniform_frame() {
+    StateCache::Counter stats = m_uniform_stats;
+    m_uniform_stats           = {};
+    return stats;
+}
+
+bool Shader::update(int location, const void *data, size_t size) const {
+    // writes to -1 are ignored by GL, unresolved handles cost nothing
+    if (location < 0) {
+        return false;
+    }
+    if ((size_t) location >= m_values.size()) {
+        m_uniform_stats.issued++;
+        return true;
+    }
+    UniformValueCache &cached = m_values[location];
+    if (cached.written && std::memcmp(cached.bytes.data(), data, size) == 0) {
+        m_uniform_stats.skipped++;
+        return false;
+    }
+    cached.written = true;
+    std::memcpy(cached.bytes.data(), data, size);
+    m_uniform_stats.issued++;
+    return true;
+}
+
+std::pair<Shader, Error> Shader::from_files(
+    const std::string &vertex, const std::string &fragment, const Defines &defines) {
+    return compile(vertex, fragment, defines).get();
+}
+
+std::pair<Shader, Error> Shader::from_files(
+    const std::string &vertex, const std::string &geometry, const std::string &fragment, const Defines &defines) {
+    return compile(vertex, geometry, fragment, defines).get();
+}
+
+ProgramFuture Shader::compile(const std::string &vertex, const std::string &fragment, const Defines &defines) {
+    return compile_stages({{GL_VERTEX_SHADER, vertex}, {GL_FRAGMENT_SHADER, fragment}}, defines);
+}
+
+ProgramFuture Shader::compile(
+    const std::string &vertex, const std::string &geometry, const std::string &fragment, const Defines &defines) {
+    return compile_stages(
+        {{GL_VERTEX_SHADER, vertex}, {GL_GEOMETRY_SHADER, geometry}, {GL_FRAGMENT_SHADER, fragment}}, defines);
+}
+
+ProgramFuture Shader::compile_stages(
+    const std::vector<std::pair<unsigned int, std::string>> &stages, const Defines &defines) {
+    ProgramFuture future;
+
+    std::vector<std::string> sources = {};
+    for (const auto &[type, path] : stages) {
+        auto [stage, error] = preprocess(path, defines);
+        if (error.has_value()) {
+            future.m_error = wrap(error);
+            return future;
+        }
+        sources.push_back(std::move(stage.source));
+        future.m_sources.insert(future.m_sources.end(), stage.files.begin(), stage.files.end());
+    }
+
+    // the preprocessed sources carry the defines, each permutation gets its own entry
+    future.m_key = ProgramCache::key(sources);
+    if ((future.m_program = ProgramCache::load(future.m_key))) {
+        return future;
+    }
+
+    // no status is queried here: that would stall until the driver is done, keeping it from working on the next
+    // program in the meantime
+    future.m_program = glCreateProgram();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        future.m_shaders.push_back(submit_shader(stages[i].first, sources[i]));
+        glAttachShader(future.m_program, future.m_shaders.back());
+    }
+    if (ProgramCache::enabled()) {
+        glProgramParameteri(future.m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(future.m_program);
+    return future;
+}
+
+bool Shader::parallel_compile(void *(*loader)(const char *name)) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    const char *function = nullptr;
+    for (int i = 0; i < count && ! function; ++i) {
+        std::string extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension == "GL_KHR_parallel_shader_compile") {
+            function = "glMaxShaderCompilerThreadsKHR";
+        } else if (extension == "GL_ARB_parallel_shader_compile") {
+            function = "glMaxShaderCompilerThreadsARB";
+        }
+    }
+    if (! function) {
+        return parallel = false;
+    }
+
+    auto glMaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader(function));
+    if (! glMaxShaderCompilerThreads) {
+        return parallel = false;
+    }
+    // as many threads as the implementation sees fit
+    glMaxShaderCompilerThreads(0xFFFFFFFF);
+    return parallel = true;
+}
+
+Shader::Shader(unsigned int ID, std::vector<std::filesystem::path> sources) : m_ID(ID), m_sources(std::move(sources)) {
+    if (m_ID) {
+        reflect();
+    }
+}
+
+Error Shader::check_block(const std::string &name, int binding, size_t size) const {
+    auto block =
+        std::find_if(m_blocks.begin(), m_blocks.end(), [&](const BlockInfo &block) { return block.name == name; });
+    if (block == m_blocks.end()) {
+        return {};
+    }
+    if (block->binding != binding) {
+        return wrap("block '" + name + "' bound to " + std::to_string(block->binding) + ", expected " +
+                    std::to_string(binding));
+    }
+    // drivers may pad a storage block ending in an unsized array to a whole vec4
+    size_t padded = block->interface == GL_SHADER_STORAGE_BLOCK ? (size + 15) / 16 * 16 : size;
+    if ((size_t) block->data_size < size || (size_t) block->data_size > padded) {
+        return wrap("block '" + name + "' is " + std::to_string(block->data_size) + " bytes, expected " +
+                    std::to_string(size));
+    }
+    return {};
+}
+
+StateCache::Counter Shader::m_uniform_stats = {};
+
+static std::string resource_name(unsigned int program, unsigned int interface, unsigned int index, int length) {
+    std::vector<char> name(length);
+    glGetProgramResourceName(program, interface, index, length, nullptr, name.data());
+    return name.data();
+}
+
+void Shader::reflect() {
+    int count = 0;
+    glGetProgramInterfaceiv(m_ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    const unsigned int properties[] = {GL_NAME_LENGTH, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX};
+    for (int i = 0; i < count; ++i) {
+        int values[std::size(properties)] = {};
+        glGetProgramResourceiv(
+            m_ID, GL_UNIFORM, i, std::size(properties), properties, std::size(values), nullptr, values);
+        auto [length, location, type, size, block] = values;
+        // members of blocks have no location, they are written through their buffer
+        if (block != -1 || location == -1) {
+            continue;
+        }
+        // arrays are listed as their first element, looked up by their bare name as glGetUniformLocation does
+        std::string name = resource_name(m_ID, GL_UNIFORM, i, length);
+        if (name.ends_with("[0]")) {
+            name.resize(name.size() - 3);
+        }
+        m_uniforms.push_back({name, location, (unsigned int) type, size});
+    }
+    std::sort(m_uniforms.begin(), m_uniforms.end(), [](const UniformInfo &a, const UniformInfo &b) {
+        return a.name < b.name;
+    });
+    for (const UniformInfo &uniform : m_uniforms) {
+        m_values.resize(std::max(m_values.size(), (size_t) (uniform.location + uniform.size)));
     }
-    return {Shader(shaderID), {}};
+
+    const unsigned int block_properties[] = {GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+    for (unsigned int interface : {GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK}) {
+        glGetProgramInterfaceiv(m_ID, interface, GL_ACTIVE_RESOURCES, &count);
+        for (int i = 0; i < count; ++i) {
+            int values[std::size(block_properties)] = {};
+            glGetProgramResourceiv(m_ID, interface, i, std::size(block_properties), block_properties,
+                std::size(values), nullptr, values);
+            auto [length, binding, data_size] = values;
+            m_blocks.push_back({resource_name(m_ID, interface, i, length), interface, binding, data_size});
+        }
+    }
+    std::sort(m_blocks.begin(), m_blocks.end(), [](const BlockInfo &a, const BlockInfo &b) { return a.name < b.name; });
+}
+
+static bool is_sampler(unsigned int type) {
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static const char *value_names[] = {"bool", "int", "float", "f3", "f4", "glm::vec3", "glm::vec4", "glm::mat4"};
+static_assert(std::size(value_names) == std::variant_size_v<UniformValue>);
+
+// whether a uniform declared as `type` can be written with `value`, following the glUniform* rules
+static bool accepts(unsigned int type, const UniformValue &value) {
+    return std::visit(
+        [type](auto &&value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, bool>) {
+                return type == GL_BOOL;
+            } else if constexpr (std::is_same_v<T, int>) {
+                return type == GL_INT || type == GL_BOOL || is_sampler(type);
+            } else if constexpr (std::is_same_v<T, float>) {
+                return type == GL_FLOAT || type == GL_BOOL;
+            } else if constexpr (std::is_same_v<T, f3> || std::is_same_v<T, glm::vec3>) {
+                return type == GL_FLOAT_VEC3 || type == GL_BOOL_VEC3;
+            } else if constexpr (std::is_same_v<T, f4> || std::is_same_v<T, glm::vec4>) {
+                return type == GL_FLOAT_VEC4 || type == GL_BOOL_VEC4;
+            } else {
+                return type == GL_FLOAT_MAT4;
+            }
+        },
+        value);
+}
+
+std::pair<int, Error> Shader::get_uniform_location(const std::string &name, const UniformValue &value) const {
+    // `name[i]` addresses the i-th element of an array, elements have consecutive locations
+    std::string base = name;
+    int element      = 0;
+    if (size_t bracket = name.find_last_of('['); bracket != std::string::npos && name.ends_with(']')) {
+        base = name.substr(0, bracket);
+        try {
+            element = std::stoi(name.substr(bracket + 1));
+        } catch (const std::exception &) {
+            element = -1;
+        }
+    }
+
+    auto uniform = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), base,
+        [](const UniformInfo &uniform, const std::string &name) { return uniform.name < name; });
+    if (uniform == m_uniforms.end() || uniform->name != base || element < 0 || element >= uniform->size) {
+        return {-1, wrap("could not find active uniform '" + name + "'")};
+    }
+    if (! accepts(uniform->type, value)) {
+        std::ostringstream oss;
+        oss << "uniform '" << name << "' of type 0x" << std::hex << uniform->type << " cannot be written with a "
+            << value_names[value.index()];
+        return {-1, wrap(oss.str())};
+    }
+    return {uniform->location + element, {}};
 }
 
-Shader::Shader(unsigned int ID) : m_ID(ID) {}
+ProgramFuture::ProgramFuture(ProgramFuture &&other)
+    : m_error(std::move(other.m_error)), m_program(other.m_program), m_shaders(std::move(other.m_shaders)),
+      m_key(std::move(other.m_key)), m_sources(std::move(other.m_sources)) {
+    other.m_program = 0;
+    other.m_shaders.clear();
+}
 
-std::pair<int, Error> Shader::get_uniform_location(const std::string &name) {
-    if (m_location_cache.contains(name)) {
-        return {m_location_cache[name], {}};
+ProgramFuture::~ProgramFuture() {
+    for (unsigned int shader : m_shaders) {
+        glDeleteShader(shader);
+    }
+    if (m_program) {
+        glDeleteProgram(m_program);
     }
-    int location = glGetUniformLocation(m_ID, name.c_str());
-    if (location == -1) {
-        return {location, wrap("glGetUniformLocation: could not find location of '" + name + "'")};
+}
+
+bool ProgramFuture::ready() const {
+    // without the extension every query blocks, the program is as ready as it will get by waiting
+    if (! parallel || m_shaders.empty()) {
+        return true;
+    }
+    int result = 0;
+    glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &result);
+    return result == GL_TRUE;
+}
+
+std::pair<Shader, Error> ProgramFuture::get() {
+    if (m_error.has_value()) {
+        return {Shader(0), wrap(m_error)};
+    }
+
+    unsigned int program = std::exchange(m_program, 0);
+    if (! m_shaders.empty()) {
+        std::vector<unsigned int> shaders = std::exchange(m_shaders, {});
+
+        // compile errors say more than the link error they lead to
+        Error error = {};
+        for (size_t i = 0; i < shaders.size() && ! error.has_value(); ++i) {
+            error = check_shader(shaders[i]);
+        }
+        if (! error.has_value()) {
+            error = check_program(program, GL_LINK_STATUS);
+        }
+        for (unsigned int shader : shaders) {
+            glDeleteShader(shader);
+        }
+
+        if (! error.has_value()) {
+            glValidateProgram(program);
+            error = check_program(program, GL_VALIDATE_STATUS);
+        }
+        if (error.has_value()) {
+            glDeleteProgram(program);
+            return {Shader(0), wrap(error)};
+        }
+        ProgramCache::store(m_key, program);
     }
-    return {m_location_cache[name] = location, {}};
+    return {Shader(program, std::move(m_sources)), Error {}};
 }
@@ -1,35 +1,47 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <filesystem>
 #include <string>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "error.hpp"
+#include "preprocessor.hpp"
+#include "state_cache.hpp"
 
-using f3      = std::tuple<float, float, float>;
-using f4      = std::tuple<float, float, float, float>;
-using Uniform = std::pair<std::string, std::variant<bool, int, float, f3, f4, glm::vec3, glm::vec4, glm::mat4>>;
+using f3           = std::tuple<float, float, float>;
+using f4           = std::tuple<float, float, float, float>;
+using UniformValue = std::variant<bool, int, float, f3, f4, glm::vec3, glm::vec4, glm::mat4>;
+using Uniform      = std::pair<std::string, UniformValue>;
 
-struct Light {
-    glm::vec4 position = {0.0f, 0.0f, 0.0f, 0.0f};
-
-    bool is_directional = false;
-    glm::vec3 direction = {0.0f, 0.0f, 0.0f};
-    float cut_off       = 0.0f;
-    float outer_cut_off = 0.0f;
+// location of a uniform resolved once by `Shader::resolve`, written without any name lookup by `Shader::set`
+template <typename T> struct UniformHandle {
+    int location = -1;
+};
 
-    glm::vec3 ambient  = {1.0f, 1.0f, 1.0f};
-    glm::vec3 diffuse  = {1.0f, 1.0f, 1.0f};
-    glm::vec3 specular = {1.0f, 1.0f, 1.0f};
+// active uniform of the default block, array elements past the first are reached through `name[i]`
+struct UniformInfo {
+    std::string name;
+    int location;
+    unsigned int type;
+    int size;
+};
 
-    float constant  = 1.0f;
-    float linear    = 0.0f;
-    float quadratic = 0.0f;
+// active uniform or shader storage block
+struct BlockInfo {
+    std::string name;
+    // GL_UNIFORM_BLOCK or GL_SHADER_STORAGE_BLOCK
+    unsigned int interface;
+    int binding;
+    int data_size;
 };
 
+class ProgramFuture;
+
 class Shader {
   public:
     Shader(Shader &&other);
@@ -39,8 +51,6 @@ class Shader {
     void bind() const;
     void unbind() const;
 
-    Error set_lights(const std::string &name, const std::vector<Light> &lights);
-
     Error set_uniforms(const std::vector<Uniform> &uniforms);
 
     Error set_uniform(const std::string &name, bool);
@@ -52,16 +62,109 @@ class Shader {
     Error set_uniform(const std::string &name, const glm::vec4 &vector);
     Error set_uniform(const std::string &name, const glm::mat4 &matrix);
 
-    static std::pair<Shader, Error> from_files(const std::string &vertex, const std::string &fragment);
+    // fails if `name` is not an active uniform or if its type does not take a `T`
+    template <typename T> Error resolve(const std::string &name, UniformHandle<T> &handle) {
+        auto [location, error] = get_uniform_location(name, UniformValue(std::in_place_type<T>));
+        if (error.has_value()) {
+            return wrap(error);
+        }
+        handle.location = location;
+        return {};
+    }
+
+    // writes are skipped when the location already holds the bitwise same value
+    void set(UniformHandle<bool> handle, bool value) const;
+    void set(UniformHandle<int> handle, int value) const;
+    void set(UniformHandle<float> handle, float value) const;
+    void set(UniformHandle<f3> handle, const f3 &value) const;
+    void set(UniformHandle<f4> handle, const f4 &value) const;
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3 &vector) const;
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4 &vector) const;
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4 &matrix) const;
+
+    // `defines` select the permutation, every permutation is a program of its own
+    static std::pair<Shader, Error> from_files(
+        const std::string &vertex, const std::string &fragment, const Defines &defines = {});
+    static std::pair<Shader, Error> from_files(
+        const std::string &vertex, const std::string &geometry, const std::string &fragment, const Defines &defines);
+    // submits the compilation and link of a program and returns without waiting for the driver
+    static ProgramFuture compile(const std::string &vertex, const std::string &fragment, const Defines &defines = {});
+    static ProgramFuture compile(
+        const std::string &vertex, const std::string &geometry, const std::string &fragment, const Defines &defines);
+
+    // lets the driver compile on its own threads through GL_KHR_parallel_shader_compile (or its ARB twin), to be
+    // called once with the loader handed to glad; tells whether it is available
+    static bool parallel_compile(void *(*loader)(const char *name));
+
+    // every file the program was built from, includes comprised
+    const std::vector<std::filesystem::path> &sources() const { return m_sources; }
+
+    // reflected once after the link, sorted by name
+    const std::vector<UniformInfo> &uniforms() const { return m_uniforms; }
+    const std::vector<BlockInfo> &blocks() const { return m_blocks; }
+
+    // glUniform* calls issued and skipped by all programs since the previous call
+    static StateCache::Counter uniform_frame();
+
+    // fails if the program has an active block `name` not bound to `binding` or whose size differs from `size`
+    Error check_block(const std::string &name, int binding, size_t size) const;
 
     Shader(const Shader &other) = delete;
     Shader &operator=(const Shader &other) = delete;
 
   private:
     unsigned int m_ID;
-    std::unordered_map<std::string, int> m_location_cache;
+    std::vector<std::filesystem::path> m_sources;
+    std::vector<UniformInfo> m_uniforms;
+    std::vector<BlockInfo> m_blocks;
+
+    // last value written to each location, a mat4 at most
+    struct UniformValueCache {
+        bool written = false;
+        std::array<std::byte, sizeof(glm::mat4)> bytes;
+    };
+    mutable std::vector<UniformValueCache> m_values;
+
+    static StateCache::Counter m_uniform_stats;
+
+    Shader(unsigned int ID, std::vector<std::filesystem::path> sources = {});
+
+    // `stages` are (shader type, path) pairs, in pipeline order
+    static ProgramFuture compile_stages(
+        const std::vector<std::pair<unsigned int, std::string>> &stages, const Defines &defines);
+
+    void reflect();
+    // records `data` as the value of `location` and tells whether it must be written
+    bool update(int location, const void *data, size_t size) const;
+    // never queries the driver, `value` only carries the type written to the uniform
+    std::pair<int, Error> get_uniform_location(const std::string &name, const UniformValue &value) const;
+
+    friend class ProgramFuture;
+};
+
+// Program being compiled and linked by the driver. `ready` never blocks; `get` waits for the program and reports
+// compile and link errors. Shader objects and programs never got are released on destruction.
+class ProgramFuture {
+  public:
+    ProgramFuture(ProgramFuture &&other);
+    ~ProgramFuture();
+
+    bool ready() const;
+    std::pair<Shader, Error> get();
+
+    ProgramFuture(const ProgramFuture &other)            = delete;
+    ProgramFuture &operator=(const ProgramFuture &other) = delete;
+
+  private:
+    ProgramFuture() = default;
+
+    Error m_error          = {};
+    unsigned int m_program = 0;
+    // left empty for programs loaded from the binary cache, already linked
+    std::vector<unsigned int> m_shaders = {};
 
-    Shader(unsigned int ID);
+    std::string m_key                            = {};
+    std::vector<std::filesystem::path> m_sources = {};
 
-    std::pair<int, Error> get_uniform_location(const std::string &name);
+    friend class Shader;
 };
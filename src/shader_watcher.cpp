@@ -0,0 +1,90 @@
+#include "shader_watcher.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+std::pair<std::unique_ptr<ShaderWatcher>, Error> ShaderWatcher::watch(const std::filesystem::path &directory) {
+    int inotify = inotify_init1(IN_CLOEXEC);
+    if (inotify == -1) {
+        return {nullptr, wrap("inotify_init1: " + std::string(std::strerror(errno)))};
+    }
+
+    // editors either rewrite a file in place or write a copy and move it over the original
+    if (inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        Error error = wrap("inotify_add_watch: " + directory.string() + ": " + std::strerror(errno));
+        close(inotify);
+        return {nullptr, error};
+    }
+
+    int stop = eventfd(0, EFD_CLOEXEC);
+    if (stop == -1) {
+        close(inotify);
+        return {nullptr, wrap("eventfd: " + std::string(std::strerror(errno)))};
+    }
+
+    std::unique_ptr<ShaderWatcher> watcher(new ShaderWatcher(inotify, stop));
+    watcher->m_thread = std::thread(&ShaderWatcher::run, watcher.get());
+    return {std::move(watcher), Error {}};
+}
+
+ShaderWatcher::ShaderWatcher(int inotify, int stop) : m_inotify(inotify), m_stop(stop) {}
+
+ShaderWatcher::~ShaderWatcher() {
+    uint64_t one = 1;
+    if (write(m_stop, &one, sizeof(one)) == sizeof(one)) {
+        m_thread.join();
+    } else {
+        m_thread.detach();
+    }
+    close(m_stop);
+    close(m_inotify);
+}
+
+std::vector<std::string> ShaderWatcher::changes() {
+    if (! m_changed.exchange(false, std::memory_order_acquire)) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::exchange(m_changes, {});
+}
+
+void ShaderWatcher::run() {
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{m_inotify, POLLIN, 0}, {m_stop, POLLIN, 0}};
+
+    while (true) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0) {
+            return;
+        }
+
+        ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            std::string name = event->len > 0 ? event->name : "";
+            if (! name.empty() && std::find(m_changes.begin(), m_changes.end(), name) == m_changes.end()) {
+                m_changes.push_back(name);
+            }
+        }
+        m_changed.store(! m_changes.empty(), std::memory_order_release);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "error.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Reports the files written in a directory. A background thread blocks on inotify, the render loop only reads an
+// atomic flag, so a frame where nothing changed costs no system call.
+class ShaderWatcher {
+  public:
+    static std::pair<std::unique_ptr<ShaderWatcher>, Error> watch(const std::filesystem::path &directory);
+    ~ShaderWatcher();
+
+    // names of the files written since the previous call, without duplicates
+    std::vector<std::string> changes();
+
+  private:
+    ShaderWatcher(int inotify, int stop);
+
+    void run();
+
+    int m_inotify;
+    // eventfd waking the thread up on destruction
+    int m_stop;
+    std::thread m_thread;
+
+    std::atomic<bool> m_changed = false;
+    std::mutex m_mutex;
+    std::vector<std::string> m_changes = {};
+};
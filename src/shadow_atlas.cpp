@@ -0,0 +1,275 @@
+#include "shadow_atlas.hpp"
+
+#include <glad/glad.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "state_cache.hpp"
+
+// casters closer to the light than this are clipped
+constexpr static float near_plane = 0.05f;
+
+// view direction and up vector of each face, in the layer order of cube maps
+static const std::array<std::pair<glm::vec3, glm::vec3>, 6> faces = {{
+    {{1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+    {{-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},
+    {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},
+    {{0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},
+    {{0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}},
+}};
+
+// depth comparison filtered over the four nearest texels
+static void shadow_parameters(unsigned int target) {
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+}
+
+static unsigned int depth_framebuffer(unsigned int texture) {
+    unsigned int framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return framebuffer;
+}
+
+ShadowAtlas::Stats &ShadowAtlas::Stats::operator+=(const Stats &other) {
+    renders += other.renders;
+    stale += other.stale;
+    return *this;
+}
+
+ShadowAtlas::ShadowAtlas(ShadowAtlasDimensions dimensions)
+    : m_dimensions(dimensions), m_maps(dimensions.cubes + dimensions.spots * dimensions.spots),
+      m_buffer(m_maps.size() * sizeof(ShadowStd430), shadows_binding) {
+    const float far = 1.0f;
+
+    glGenTextures(1, &m_cubes);
+    StateCache::bind_texture(GL_TEXTURE0 + shadow_cubes_unit, GL_TEXTURE_CUBE_MAP_ARRAY, m_cubes);
+    glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY,
+        1,
+        GL_DEPTH_COMPONENT32F,
+        dimensions.cube_size,
+        dimensions.cube_size,
+        6 * std::max(dimensions.cubes, 1u));
+    shadow_parameters(GL_TEXTURE_CUBE_MAP_ARRAY);
+    glClearTexImage(m_cubes, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &far);
+
+    glGenTextures(1, &m_spots);
+    StateCache::bind_texture(GL_TEXTURE0 + shadow_spots_unit, GL_TEXTURE_2D, m_spots);
+    unsigned int side = std::max(dimensions.spots, 1u) * dimensions.spot_size;
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, side, side);
+    shadow_parameters(GL_TEXTURE_2D);
+    glClearTexImage(m_spots, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &far);
+
+    m_cube_framebuffer = depth_framebuffer(m_cubes);
+    m_spot_framebuffer = depth_framebuffer(m_spots);
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    glDeleteFramebuffers(1, &m_cube_framebuffer);
+    glDeleteFramebuffers(1, &m_spot_framebuffer);
+    StateCache::forget_texture(m_cubes);
+    StateCache::forget_texture(m_spots);
+    glDeleteTextures(1, &m_cubes);
+    glDeleteTextures(1, &m_spots);
+}
+
+int ShadowAtlas::add(const Light &light, bool cone) {
+    float far = light_radius(light);
+    if (light.position.w == 0.0f || far >= unbounded_radius) {
+        return -1;
+    }
+
+    auto first = m_maps.begin() + (cone ? m_dimensions.cubes : 0);
+    auto last  = cone ? m_maps.end() : m_maps.begin() + m_dimensions.cubes;
+    auto free  = std::find_if(first, last, [](const Map &map) { return ! map.used; });
+    if (free == last) {
+        return -1;
+    }
+    int shadow = free - m_maps.begin();
+
+    *free = {
+        .used          = true,
+        .stale         = false,
+        .stale_since   = 0,
+        .position      = glm::vec3(light.position),
+        .direction     = light.direction,
+        .outer_cut_off = light.outer_cut_off,
+        .far           = far,
+    };
+    stale(*free);
+    // a previous light may have left its depths there
+    clear(shadow);
+    write(pass(shadow));
+    return shadow;
+}
+
+void ShadowAtlas::remove(int shadow) {
+    if (shadow >= 0) {
+        m_maps[shadow] = {};
+    }
+}
+
+void ShadowAtlas::set(int shadow, const Light &light) {
+    if (shadow < 0) {
+        return;
+    }
+    Map &map           = m_maps[shadow];
+    glm::vec3 position = glm::vec3(light.position);
+    float far          = light_radius(light);
+    // cube maps look every way
+    bool turned = ! is_cube(shadow) && (light.direction != map.direction || light.outer_cut_off != map.outer_cut_off);
+    if (position != map.position || far != map.far || turned) {
+        map.position      = position;
+        map.direction     = light.direction;
+        map.outer_cut_off = light.outer_cut_off;
+        map.far           = far;
+        stale(map);
+    }
+}
+
+std::vector<ShadowPass> ShadowAtlas::schedule(unsigned int budget) {
+    std::vector<int> stale = {};
+    for (size_t i = 0; i < m_maps.size(); ++i) {
+        if (m_maps[i].used && m_maps[i].stale) {
+            stale.push_back(i);
+        }
+    }
+    std::stable_sort(stale.begin(), stale.end(), [this](int a, int b) {
+        return m_maps[a].stale_since < m_maps[b].stale_since;
+    });
+    stale.resize(std::min(stale.size(), (size_t) budget));
+
+    std::vector<ShadowPass> passes = {};
+    for (int shadow : stale) {
+        passes.push_back(pass(shadow));
+    }
+    return passes;
+}
+
+void ShadowAtlas::begin(const ShadowPass &pass) {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previous_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, m_previous_viewport);
+
+    if (pass.cube >= 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_cube_framebuffer);
+        glViewport(0, 0, m_dimensions.cube_size, m_dimensions.cube_size);
+    } else {
+        unsigned int tile = pass.shadow - m_dimensions.cubes, size = m_dimensions.spot_size;
+        glBindFramebuffer(GL_FRAMEBUFFER, m_spot_framebuffer);
+        glViewport(tile % m_dimensions.spots * size, tile / m_dimensions.spots * size, size, size);
+    }
+    clear(pass.shadow);
+    write(pass);
+
+    m_maps[pass.shadow].stale = false;
+    m_stats.renders += 1;
+}
+
+void ShadowAtlas::end() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_previous_framebuffer);
+    glViewport(m_previous_viewport[0], m_previous_viewport[1], m_previous_viewport[2], m_previous_viewport[3]);
+}
+
+void ShadowAtlas::bind_textures() const {
+    StateCache::bind_texture(GL_TEXTURE0 + shadow_cubes_unit, GL_TEXTURE_CUBE_MAP_ARRAY, m_cubes);
+    StateCache::bind_texture(GL_TEXTURE0 + shadow_spots_unit, GL_TEXTURE_2D, m_spots);
+}
+
+ShadowAtlas::Stats ShadowAtlas::frame() {
+    Stats stats = m_stats;
+    stats.stale = std::count_if(m_maps.begin(), m_maps.end(), [](const Map &map) { return map.used && map.stale; });
+    m_stats     = {};
+    m_frame += 1;
+    return stats;
+}
+
+Error ShadowAtlas::status() const {
+    for (unsigned int framebuffer : {m_cube_framebuffer, m_spot_framebuffer}) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            std::ostringstream oss;
+            oss << "incomplete shadow map framebuffer, status 0x" << std::hex << status;
+            return wrap(oss.str());
+        }
+    }
+    return {};
+}
+
+ShadowPass ShadowAtlas::pass(int shadow) const {
+    const Map &map  = m_maps[shadow];
+    ShadowPass pass = {
+        .shadow           = shadow,
+        .cube             = is_cube(shadow) ? shadow : -1,
+        .position         = map.position,
+        .far              = map.far,
+        .view_projections = {},
+    };
+    if (is_cube(shadow)) {
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, map.far);
+        for (size_t face = 0; face < faces.size(); ++face) {
+            auto [direction, up]         = faces[face];
+            pass.view_projections[face] = projection * glm::lookAt(map.position, map.position + direction, up);
+        }
+    } else {
+        // the cone fills the tile, looking straight up or down needs another up vector
+        glm::vec3 up = std::abs(map.direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        float fov    = 2.0f * std::acos(std::clamp(map.outer_cut_off, 0.0f, 1.0f));
+        pass.view_projections[0] = glm::perspective(std::min(fov, glm::radians(170.0f)), 1.0f, near_plane, map.far) *
+                                   glm::lookAt(map.position, map.position + map.direction, up);
+    }
+    return pass;
+}
+
+void ShadowAtlas::clear(int shadow) const {
+    const float far = 1.0f;
+    if (is_cube(shadow)) {
+        unsigned int size = m_dimensions.cube_size;
+        glClearTexSubImage(m_cubes, 0, 0, 0, 6 * shadow, size, size, 6, GL_DEPTH_COMPONENT, GL_FLOAT, &far);
+    } else {
+        unsigned int tile = shadow - m_dimensions.cubes, size = m_dimensions.spot_size;
+        glClearTexSubImage(m_spots,
+            0,
+            tile % m_dimensions.spots * size,
+            tile / m_dimensions.spots * size,
+            0,
+            size,
+            size,
+            1,
+            GL_DEPTH_COMPONENT,
+            GL_FLOAT,
+            &far);
+    }
+}
+
+void ShadowAtlas::write(const ShadowPass &pass) const {
+    ShadowStd430 entry = {.view_projection = glm::mat4(1.0f), .tile = {}, .cube = pass.cube, .padding = {}};
+    if (pass.cube < 0) {
+        unsigned int tile     = pass.shadow - m_dimensions.cubes;
+        float scale           = 1.0f / m_dimensions.spots;
+        entry.view_projection = pass.view_projections[0];
+        entry.tile            = {tile % m_dimensions.spots * scale, tile / m_dimensions.spots * scale, scale, scale};
+    }
+    m_buffer.write(&entry, sizeof(entry), pass.shadow * sizeof(ShadowStd430));
+}
+
+void ShadowAtlas::stale(Map &map) {
+    if (! map.stale) {
+        map.stale       = true;
+        map.stale_since = m_frame;
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "error.hpp"
+#include "light.hpp"
+#include "storage_buffer.hpp"
+
+constexpr static unsigned int shadows_binding = 7;
+// texture units of the cube map array and of the spot atlas, mirrored by the sampler bindings of res/shadows.glsl
+constexpr static unsigned int shadow_cubes_unit = 6;
+constexpr static unsigned int shadow_spots_unit = 7;
+
+struct ShadowAtlasDimensions {
+    // `cubes` cube maps of `cube_size` texels a side, for point lights
+    unsigned int cube_size = 512;
+    unsigned int cubes     = 16;
+    // `spots` x `spots` tiles of `spot_size` texels a side, for spot lights
+    unsigned int spot_size = 1024;
+    unsigned int spots     = 2;
+};
+
+// std430 mirror of `struct Shadow` in res/shadows.glsl, indexed by `Light::shadow`
+struct ShadowStd430 {
+    // spot maps: world to light clip space, and the tile as offset and scale in atlas coordinates
+    glm::mat4 view_projection;
+    glm::vec4 tile;
+    // cube maps: the cube in the array, -1 for spot maps
+    int cube;
+    int padding[3];
+};
+static_assert(sizeof(ShadowStd430) == 96);
+
+// render of one map as set up by `ShadowAtlas::begin`, for the programs drawing the casters
+struct ShadowPass {
+    int shadow;
+    // -1 for spot maps
+    int cube;
+    glm::vec3 position;
+    // maps store the distance to the light divided by `far`, the light's radius
+    float far;
+    // spot maps use the first, cube maps one per face in layer order
+    std::array<glm::mat4, 6> view_projections;
+};
+
+// Shadow maps kept from frame to frame. Point lights get a cube map of a cube map array, rendered in a single layered
+// pass; spot lights get a tile of a 2D atlas. A map is only rendered again once stale, when its light moved or turned,
+// and the stale maps are rendered a few per frame, the longest stale first. The casters, the cubes, never move: static
+// lights cost nothing after their first render.
+class ShadowAtlas {
+  public:
+    struct Stats {
+        unsigned int renders = 0;
+        // maps still stale at the end of a frame, left for the next ones
+        unsigned int stale = 0;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+    ShadowAtlas(ShadowAtlasDimensions dimensions = {});
+    ~ShadowAtlas();
+
+    // a map for `light`, a cube map or, with `cone`, a spot tile; -1 when none is left or the light has no radius.
+    // The map reads as unshadowed until its first render.
+    int add(const Light &light, bool cone);
+    void remove(int shadow);
+    // the map goes stale if the light moved, turned or changed reach; -1 is ignored like in `remove`
+    void set(int shadow, const Light &light);
+
+    // stale maps to render this frame, `budget` at most
+    std::vector<ShadowPass> schedule(unsigned int budget);
+    // binds the map of `pass` as the depth target, cleared, with its viewport; the map is up to date from there on
+    void begin(const ShadowPass &pass);
+    // restores the framebuffer and viewport bound before `begin`
+    void end() const;
+
+    // the cube map array and the spot atlas, on `shadow_cubes_unit` and `shadow_spots_unit`
+    void bind_textures() const;
+
+    // renders since the previous call, and the maps left stale
+    Stats frame();
+
+    Error status() const;
+
+    ShadowAtlas(const ShadowAtlas &other)            = delete;
+    ShadowAtlas &operator=(const ShadowAtlas &other) = delete;
+
+  private:
+    struct Map {
+        bool used  = false;
+        bool stale = false;
+        // frame the map went stale on, older ones are rendered first
+        unsigned int stale_since = 0;
+
+        glm::vec3 position  = {};
+        glm::vec3 direction = {};
+        float outer_cut_off = 0.0f;
+        float far           = 0.0f;
+    };
+
+    ShadowAtlasDimensions m_dimensions;
+    // cube maps first, then the spot tiles row by row
+    std::vector<Map> m_maps;
+
+    unsigned int m_cubes;
+    unsigned int m_spots;
+    unsigned int m_cube_framebuffer;
+    unsigned int m_spot_framebuffer;
+    StorageBuffer m_buffer;
+
+    unsigned int m_frame = 0;
+    Stats m_stats        = {};
+
+    // what `end` restores
+    int m_previous_framebuffer = 0;
+    int m_previous_viewport[4] = {};
+
+    bool is_cube(int shadow) const { return (unsigned int) shadow < m_dimensions.cubes; }
+    ShadowPass pass(int shadow) const;
+    // clears the map of `shadow` to the far plane
+    void clear(int shadow) const;
+    // writes the `Shadow` entry of `pass`
+    void write(const ShadowPass &pass) const;
+    void stale(Map &map);
+};
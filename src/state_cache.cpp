@@ -0,0 +1,121 @@
+#include "state_cache.hpp"
+
+#include <glad/glad.h>
+
+unsigned int StateCache::m_program                                                          = 0;
+unsigned int StateCache::m_vertex_array                                                     = 0;
+std::unordered_map<unsigned int, unsigned int> StateCache::m_element_buffers                = {};
+std::unordered_map<unsigned int, unsigned int> StateCache::m_buffers                        = {};
+unsigned int StateCache::m_active_texture                                                   = GL_TEXTURE0;
+std::array<StateCache::TextureBinding, StateCache::max_texture_units> StateCache::m_textures = {};
+StateCache::Stats StateCache::m_stats                                                       = {};
+
+StateCache::Counter &StateCache::Counter::operator+=(const Counter &other) {
+    issued += other.issued;
+    skipped += other.skipped;
+    return *this;
+}
+
+// records the outcome of a bind and tells whether it must be issued
+static bool update(StateCache::Counter &counter, unsigned int &current, unsigned int ID) {
+    if (current == ID) {
+        counter.skipped += 1;
+        return false;
+    }
+    counter.issued += 1;
+    current = ID;
+    return true;
+}
+
+StateCache::Stats &StateCache::Stats::operator+=(const Stats &other) {
+    program += other.program;
+    vertex_array += other.vertex_array;
+    buffer += other.buffer;
+    active_texture += other.active_texture;
+    texture += other.texture;
+    uniform += other.uniform;
+    return *this;
+}
+
+void StateCache::use_program(unsigned int ID) {
+    if (update(m_stats.program, m_program, ID)) {
+        glUseProgram(ID);
+    }
+}
+
+void StateCache::bind_vertex_array(unsigned int ID) {
+    if (update(m_stats.vertex_array, m_vertex_array, ID)) {
+        glBindVertexArray(ID);
+    }
+}
+
+void StateCache::bind_buffer(unsigned int target, unsigned int ID) {
+    unsigned int &current = target == GL_ELEMENT_ARRAY_BUFFER ? m_element_buffers[m_vertex_array] : m_buffers[target];
+    if (update(m_stats.buffer, current, ID)) {
+        glBindBuffer(target, ID);
+    }
+}
+
+void StateCache::bind_buffer_range(
+    unsigned int target, unsigned int index, unsigned int ID, size_t offset, size_t size) {
+    m_stats.buffer.issued += 1;
+    m_buffers[target] = ID;
+    glBindBufferRange(target, index, ID, offset, size);
+}
+
+void StateCache::bind_texture(unsigned int unit, unsigned int target, unsigned int ID) {
+    if (update(m_stats.active_texture, m_active_texture, unit)) {
+        glActiveTexture(unit);
+    }
+
+    // a unit keeps one binding per target, only the last one is shadowed: at worst a bind is issued twice
+    TextureBinding &current = m_textures[unit - GL_TEXTURE0];
+    if (current.target != target) {
+        current = {target, 0};
+    }
+    if (update(m_stats.texture, current.ID, ID)) {
+        glBindTexture(target, ID);
+    }
+}
+
+void StateCache::forget_program(unsigned int ID) {
+    if (m_program == ID) {
+        m_program = 0;
+    }
+}
+
+void StateCache::forget_vertex_array(unsigned int ID) {
+    // deleting the bound vertex array reverts to the default one
+    if (m_vertex_array == ID) {
+        m_vertex_array = 0;
+    }
+    m_element_buffers.erase(ID);
+}
+
+void StateCache::forget_buffer(unsigned int ID) {
+    for (auto &[_, current] : m_buffers) {
+        if (current == ID) {
+            current = 0;
+        }
+    }
+    for (auto &[_, current] : m_element_buffers) {
+        if (current == ID) {
+            current = 0;
+        }
+    }
+}
+
+void StateCache::forget_texture(unsigned int ID) {
+    // deleting a texture unbinds it from every unit
+    for (TextureBinding &current : m_textures) {
+        if (current.ID == ID) {
+            current = {};
+        }
+    }
+}
+
+StateCache::Stats StateCache::frame() {
+    Stats stats = m_stats;
+    m_stats     = {};
+    return stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+
+// Shadow copy of the GL binding state. Every bind of the repo goes through it so that a call which would not change the
+// current binding is never issued; names must be forgotten when deleted since GL recycles them.
+class StateCache {
+  public:
+    struct Counter {
+        unsigned int issued  = 0;
+        unsigned int skipped = 0;
+
+        Counter &operator+=(const Counter &other);
+    };
+
+    struct Stats {
+        Counter program;
+        Counter vertex_array;
+        Counter buffer;
+        Counter active_texture;
+        Counter texture;
+        // uniform writes, shadowed by each `Shader` and only gathered here for reporting
+        Counter uniform;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+    static void use_program(unsigned int ID);
+    static void bind_vertex_array(unsigned int ID);
+    static void bind_buffer(unsigned int target, unsigned int ID);
+    // indexed ranges are not shadowed, only the generic binding of `target` they overwrite
+    static void bind_buffer_range(unsigned int target, unsigned int index, unsigned int ID, size_t offset, size_t size);
+    // `unit` is the GL_TEXTUREi enum, as taken by glActiveTexture
+    static void bind_texture(unsigned int unit, unsigned int target, unsigned int ID);
+
+    static void forget_program(unsigned int ID);
+    static void forget_vertex_array(unsigned int ID);
+    static void forget_buffer(unsigned int ID);
+    static void forget_texture(unsigned int ID);
+
+    // counters accumulated since the previous call
+    static Stats frame();
+
+  private:
+    constexpr static size_t max_texture_units = 32;
+
+    struct TextureBinding {
+        unsigned int target = 0;
+        unsigned int ID     = 0;
+    };
+
+    static unsigned int m_program;
+    static unsigned int m_vertex_array;
+    // element array buffer bindings are part of the vertex array state
+    static std::unordered_map<unsigned int, unsigned int> m_element_buffers;
+    static std::unordered_map<unsigned int, unsigned int> m_buffers;
+    static unsigned int m_active_texture;
+    static std::array<TextureBinding, max_texture_units> m_textures;
+
+    static Stats m_stats;
+};
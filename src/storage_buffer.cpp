@@ -0,0 +1,25 @@
+#include "storage_buffer.hpp"
+#include "state_cache.hpp"
+
+#include <glad/glad.h>
+
+StorageBuffer::StorageBuffer(size_t size, unsigned int binding, const void *data) : m_binding(binding) {
+    glGenBuffers(1, &m_ID);
+    StateCache::bind_buffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, m_ID);
+}
+
+StorageBuffer::~StorageBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void StorageBuffer::bind() const { StateCache::bind_buffer(GL_SHADER_STORAGE_BUFFER, m_ID); }
+
+void StorageBuffer::unbind() const { StateCache::bind_buffer(GL_SHADER_STORAGE_BUFFER, 0); }
+
+void StorageBuffer::write(const void *data, size_t size, size_t offset) const {
+    StateCache::bind_buffer(GL_SHADER_STORAGE_BUFFER, m_ID);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
@@ -1,4 +1,5 @@
 #include "texture.hpp"
+#include "state_cache.hpp"
 
 #include <map>
 
@@ -26,8 +27,7 @@ std::pair<Texture, Error> Texture::from_file(
     unsigned int ID = 0;
     glGenTextures(1, &ID);
 
-    glActiveTexture(texture_slot);
-    glBindTexture(GL_TEXTURE_2D, ID);
+    StateCache::bind_texture(texture_slot, GL_TEXTURE_2D, ID);
 
     for (auto [parameter, value] : parameters) {
         glTexParameteri(GL_TEXTURE_2D, parameter, value);
@@ -45,8 +45,5 @@ std::pair<Texture, Error> Texture::from_file(
     return {{ID, texture_slot}, {}};
 }
 
-void Texture::bind() const {
-    glActiveTexture(m_slot);
-    glBindTexture(GL_TEXTURE_2D, m_ID);
-}
-void Texture::unbind() const { glBindTexture(GL_TEXTURE_2D, 0); }
+void Texture::bind() const { StateCache::bind_texture(m_slot, GL_TEXTURE_2D, m_ID); }
+void Texture::unbind() const { StateCache::bind_texture(m_slot, GL_TEXTURE_2D, 0); }
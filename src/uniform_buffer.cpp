@@ -0,0 +1,25 @@
+#include "uniform_buffer.hpp"
+#include "state_cache.hpp"
+
+#include <glad/glad.h>
+
+UniformBuffer::UniformBuffer(size_t size, unsigned int binding) : m_binding(binding) {
+    glGenBuffers(1, &m_ID);
+    StateCache::bind_buffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ID);
+}
+
+UniformBuffer::~UniformBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
+
+void UniformBuffer::bind() const { StateCache::bind_buffer(GL_UNIFORM_BUFFER, m_ID); }
+
+void UniformBuffer::unbind() const { StateCache::bind_buffer(GL_UNIFORM_BUFFER, 0); }
+
+void UniformBuffer::write(const void *data, size_t size, size_t offset) const {
+    StateCache::bind_buffer(GL_UNIFORM_BUFFER, m_ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
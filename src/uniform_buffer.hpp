@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+class UniformBuffer {
+  public:
+    UniformBuffer(size_t size, unsigned int binding);
+    ~UniformBuffer();
+
+    void bind() const;
+    void unbind() const;
+
+    void write(const void *data, size_t size, size_t offset = 0) const;
+
+    unsigned int binding() const { return m_binding; }
+
+  private:
+    unsigned int m_ID;
+    unsigned int m_binding;
+};
@@ -5,7 +5,11 @@
 #include <glad/glad.h>
 
 Vertex operator*(const glm::mat4 &matrix, const Vertex &vertex) {
-    return {matrix * glm::vec4(vertex.r, 1.0f), vertex.color, vertex.t, matrix * glm::vec4(vertex.normal, 1.0f)};
+    return {matrix * glm::vec4(vertex.r, 1.0f),
+        vertex.color,
+        vertex.t,
+        matrix * glm::vec4(vertex.normal, 1.0f),
+        vertex.lightmap};
 }
 
 std::vector<VertexLayout> vertex_layouts() {
@@ -13,7 +17,8 @@ std::vector<VertexLayout> vertex_layouts() {
     VertexLayout color     = {3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *) offsetof(Vertex, color)};
     VertexLayout tex_coord = {2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *) offsetof(Vertex, t)};
     VertexLayout normal    = {3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *) offsetof(Vertex, normal)};
-    return {{position, color, tex_coord, normal}};
+    VertexLayout lightmap  = {2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *) offsetof(Vertex, lightmap)};
+    return {{position, color, tex_coord, normal, lightmap}};
 }
 
 Vertices operator+(const Vertices &left, const Vertices &right) {
@@ -11,6 +11,8 @@ struct Vertex {
     glm::vec3 color {0.0f, 0.0f, 0.0f};
     glm::vec2 t {0.0f, 0.0f};
     glm::vec3 normal {0.0f, 0.0f, 0.0f};
+    // within the mesh's lightmap tile, see `unwrap`
+    glm::vec2 lightmap {0.0f, 0.0f};
 };
 
 Vertex operator*(const glm::mat4 &matrix, const Vertex &vertex);
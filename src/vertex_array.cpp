@@ -1,11 +1,12 @@
 #include "vertex_array.hpp"
+#include "state_cache.hpp"
 #include "vertex.hpp"
 
 #include <glad/glad.h>
 
 VertexArray::VertexArray(const VertexBuffer &vb) {
     glGenVertexArrays(1, &m_ID);
-    glBindVertexArray(m_ID);
+    StateCache::bind_vertex_array(m_ID);
 
     vb.bind();
     auto layouts = vertex_layouts();
@@ -16,8 +17,23 @@ VertexArray::VertexArray(const VertexBuffer &vb) {
     }
 }
 
-VertexArray::~VertexArray() { glDeleteVertexArrays(1, &m_ID); }
+VertexArray::VertexArray(const VertexBuffer &vb, const InstanceBuffer &instances) : VertexArray(vb) {
+    instances.bind();
+    auto first   = vertex_layouts().size();
+    auto layouts = instance_layouts();
+    for (size_t i = 0; i < layouts.size(); ++i) {
+        auto [count, type, normalized, stride, offset] = layouts[i];
+        glEnableVertexAttribArray(first + i);
+        glVertexAttribPointer(first + i, count, type, normalized, stride, offset);
+        glVertexAttribDivisor(first + i, 1);
+    }
+}
+
+VertexArray::~VertexArray() {
+    StateCache::forget_vertex_array(m_ID);
+    glDeleteVertexArrays(1, &m_ID);
+}
 
-void VertexArray::bind() const { glBindVertexArray(m_ID); }
+void VertexArray::bind() const { StateCache::bind_vertex_array(m_ID); }
 
-void VertexArray::unbind() const { glBindVertexArray(0); }
+void VertexArray::unbind() const { StateCache::bind_vertex_array(0); }
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "instance_buffer.hpp"
 #include "vertex_buffer.hpp"
 
 class VertexArray {
   public:
     VertexArray(const VertexBuffer &vb);
+    VertexArray(const VertexBuffer &vb, const InstanceBuffer &instances);
     ~VertexArray();
 
     void bind() const;
@@ -1,13 +1,17 @@
 #include "vertex_buffer.hpp"
+#include "state_cache.hpp"
 
 VertexBuffer::VertexBuffer(std::vector<Vertex> &&vertices) {
     glGenBuffers(1, &m_ID);
-    glBindBuffer(GL_ARRAY_BUFFER, m_ID);
+    StateCache::bind_buffer(GL_ARRAY_BUFFER, m_ID);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 }
 
-VertexBuffer::~VertexBuffer() { glDeleteBuffers(1, &m_ID); }
+VertexBuffer::~VertexBuffer() {
+    StateCache::forget_buffer(m_ID);
+    glDeleteBuffers(1, &m_ID);
+}
 
-void VertexBuffer::bind() const { glBindBuffer(GL_ARRAY_BUFFER, m_ID); }
+void VertexBuffer::bind() const { StateCache::bind_buffer(GL_ARRAY_BUFFER, m_ID); }
 
-void VertexBuffer::unbind() const { glBindBuffer(GL_ARRAY_BUFFER, 0); };
+void VertexBuffer::unbind() const { StateCache::bind_buffer(GL_ARRAY_BUFFER, 0); };
@@ -0,0 +1,65 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threads) {
+    for (unsigned int i = 1; i < std::max(threads, 1u); ++i) {
+        m_workers.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)> &task) {
+    m_task  = &task;
+    m_count = count;
+    m_next  = 0;
+    if (! m_workers.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = m_workers.size();
+        m_generation++;
+    }
+    m_start.notify_all();
+    drain();
+    if (! m_workers.empty()) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+    }
+    m_task = nullptr;
+}
+
+void WorkerPool::work() {
+    unsigned int generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]() { return m_quit || m_generation != generation; });
+            if (m_quit) {
+                return;
+            }
+            generation = m_generation;
+        }
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::drain() {
+    for (size_t i; (i = m_next.fetch_add(1)) < m_count;) {
+        (*m_task)(i);
+    }
+}
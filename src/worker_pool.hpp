@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept alive from one batch of tasks to the next. `run` hands the tasks out one index at a time to the workers
+// and to the calling thread, and returns once all of them are done.
+class WorkerPool {
+  public:
+    explicit WorkerPool(unsigned int threads = std::thread::hardware_concurrency());
+    ~WorkerPool();
+
+    // calls `task` once with every index of [0, `count`), from any thread of the pool
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+    // the calling thread comprised
+    unsigned int threads() const { return m_workers.size() + 1; }
+
+    WorkerPool(const WorkerPool &other)            = delete;
+    WorkerPool &operator=(const WorkerPool &other) = delete;
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    unsigned int m_generation = 0;
+    unsigned int m_busy       = 0;
+    bool m_quit               = false;
+
+    // batch being run
+    const std::function<void(size_t)> *m_task = nullptr;
+    size_t m_count                            = 0;
+    std::atomic<size_t> m_next                = 0;
+
+    void work();
+    void drain();
+};